@@ -0,0 +1,42 @@
+#ifndef CASEGEN_BENCH_H_
+#define CASEGEN_BENCH_H_
+
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <string>
+
+// micro benchmarks of casegen, every benchmark prints one line per variant
+
+typedef std::chrono::steady_clock BenchClock;
+
+inline double elapsed(const BenchClock::time_point &since) {
+  return std::chrono::duration<double>(BenchClock::now() - since).count();
+}
+
+inline void report(const std::string &name, const size_t ops,
+                   const double seconds) {
+  std::cout << name << ": " << seconds * 1000 << " ms, "
+            << static_cast<double>(ops) / seconds / 1e6 << " Mops/s\n";
+}
+
+// AtomicBitMap against a BitMap guarded by a mutex
+void bench_atomic_bitmap(size_t threads);
+// the methods of Graph::scan: BFS, bit matrix transitive closure and SCC
+void bench_scan(size_t threads);
+// distances from all the vertices, one BFS per source against MS-BFS
+void bench_distances(size_t threads);
+// neighbour walk on the Link pointer lists against the CSR arrays
+void bench_traverse(size_t threads);
+// graph elements from the arena against new/delete
+void bench_arena(size_t threads);
+// eulerize, arrow to fork distances and the transportation problem
+void bench_eulerize(size_t threads);
+// Euler tour of a big balanced graph, into a string, streamed and by the
+// parallel trails
+void bench_euler(size_t threads);
+// all the paths enumerated by BfsAll, many paths, on one thread and by the
+// workers, formatted as text, and one deep path
+void bench_bfs_all(size_t threads);
+
+#endif
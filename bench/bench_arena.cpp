@@ -0,0 +1,53 @@
+#include <cstddef>
+#include <iostream>
+#include <vector>
+
+#include "arena.h"
+#include "bench.h"
+#include "graph.h"
+
+using namespace std;
+
+void bench_arena(size_t) {
+  const size_t links = 1000000;
+  cout << "allocate and free " << links << " Edge and Link pairs\n";
+  Vertex a(0, ""), b(1, "");
+
+  BenchClock::time_point start = BenchClock::now();
+  {
+    vector<Edge *> edges;
+    vector<Link *> heap;
+    edges.reserve(links);
+    heap.reserve(links);
+    for (size_t i = 0; i < links; ++i) {
+      edges.push_back(new Edge(i, "", 0));
+      heap.push_back(new Link(a, b, *edges.back()));
+    }
+    for (size_t i = 0; i < links; ++i) {
+      delete heap[i];
+      delete edges[i];
+    }
+  }
+  report("  new/delete", links, elapsed(start));
+
+  start = BenchClock::now();
+  {
+    Arena arena;
+    for (size_t i = 0; i < links; ++i) {
+      Edge *e = arena.create<Edge>(i, "", 0);
+      arena.create<Link>(a, b, *e);
+    }
+  }
+  report("  arena", links, elapsed(start));
+
+  cout << "build a graph of 100000 vertices and " << links << " links\n";
+  start = BenchClock::now();
+  {
+    Graph g;
+    g.init(100000);
+    for (size_t i = 0; i < links; ++i) {
+      g.link(i % 100000, (i * 7919) % 100000, i % 4);
+    }
+  }
+  report("  init, link and release", links, elapsed(start));
+}
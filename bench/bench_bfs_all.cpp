@@ -0,0 +1,119 @@
+#include <climits>
+#include <cstddef>
+#include <iostream>
+#include <string>
+
+#include "bench.h"
+#include "case_sink.h"
+#include "graph.h"
+#include "traveller.h"
+
+using namespace std;
+
+namespace {
+
+// drops the cases, the time of the first one
+class FirstCaseSink : public CaseSink {
+public:
+  explicit FirstCaseSink(BenchClock::time_point since) : m_since(since){};
+
+  void beginCase(const Graph &, const VERTEX_ID) override {
+    if (m_first < 0) {
+      m_first = elapsed(m_since);
+    }
+  };
+  void append(const LINK_ID) override{};
+  void endCase() override{};
+
+  double first() const { return m_first; };
+
+private:
+  BenchClock::time_point m_since;
+  double m_first{-1};
+};
+
+void enumerate(const string &name, const Graph &g, const VERTEX_ID start,
+               const VERTEX_ID end, const size_t threads = 0) {
+  GraphTravellerBfsAll traveller;
+  traveller.configure({{"START", start},
+                       {"END", end},
+                       {"MAX_DEPTH", INT_MAX},
+                       {"MAX_CASES", INT_MAX},
+                       {"PARALLEL", static_cast<int>(threads)}});
+  BenchClock::time_point const since = BenchClock::now();
+  FirstCaseSink sink(since);
+  traveller.travel(g, sink);
+  double const seconds = elapsed(since);
+  cout << "  " << traveller.found() << " paths, the first one after "
+       << sink.first() * 1000 << " ms\n";
+  report(name, traveller.found(), seconds);
+}
+
+// the paths as text, into a string and by write(2) to /dev/null
+void format(const string &name, const Graph &g, const VERTEX_ID start,
+            const VERTEX_ID end) {
+  GraphTravellerBfsAll traveller;
+  traveller.configure({{"START", start},
+                       {"END", end},
+                       {"MAX_DEPTH", INT_MAX},
+                       {"MAX_CASES", INT_MAX}});
+  string trace;
+  BenchClock::time_point since = BenchClock::now();
+  traveller.travel(g, trace);
+  double seconds = elapsed(since);
+  report(name + " into a string", traveller.found(), seconds);
+  cout << "  " << trace.size() << " bytes, " << trace.size() / seconds / 1e6
+       << " MB/s\n";
+
+  FileSink null("/dev/null");
+  since = BenchClock::now();
+  traveller.travel(g, null);
+  null.flush();
+  seconds = elapsed(since);
+  report(name + " written", traveller.found(), seconds);
+  cout << "  " << trace.size() / seconds / 1e6 << " MB/s\n";
+}
+
+} // namespace
+
+void bench_bfs_all(size_t threads) {
+  // every vertex of a layer links to every vertex of the next one, width^layers
+  // paths from the source to the sink
+  const size_t width = 4, layers = 10;
+  cout << "all the paths of " << layers << " layers of " << width
+       << " vertices\n";
+  Graph layered;
+  layered.init(width * layers + 2);
+  VERTEX_ID const source = width * layers, sink = width * layers + 1;
+  for (size_t v = 0; v < width; ++v) {
+    layered.link(source, v, 0);
+    layered.link((layers - 1) * width + v, sink, 0);
+  }
+  for (size_t l = 0; l + 1 < layers; ++l) {
+    for (size_t v = 0; v < width; ++v) {
+      for (size_t w = 0; w < width; ++w) {
+        layered.link(l * width + v, (l + 1) * width + w, 0);
+      }
+    }
+  }
+  layered.scan();
+  enumerate("  layers", layered, source, sink);
+  for (size_t t : {size_t(1), threads}) {
+    enumerate("  layers, " + to_string(t) + " workers", layered, source, sink,
+              t);
+  }
+  format("  layers, formatted", layered, source, sink);
+
+  // one path as deep as the ring
+  const size_t deep = 200000;
+  cout << "the path around a ring of " << deep << " vertices\n";
+  Graph ring;
+  ring.init(deep);
+  for (size_t v = 0; v < deep; ++v) {
+    ring.link(v, (v + 1) % deep, 0);
+  }
+  ring.setReachPolicy(Graph::RP_SPARSE);
+  ring.setScanMethod(Graph::SCAN_SCC);
+  ring.scan();
+  enumerate("  ring", ring, 0, deep - 1);
+}
@@ -0,0 +1,91 @@
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "atomic_bitmap.h"
+#include "bench.h"
+#include "bitmap.h"
+
+using namespace std;
+
+namespace {
+
+const size_t VISIT_BITS = 1 << 22;
+// odd, so i * STRIDE walks all the positions in a scattered order
+const size_t STRIDE = 0x9e3779b1;
+
+// every thread tries to claim all the positions, starting at a different
+// place, like the workers of a parallel BFS sharing one visit table
+template <typename CLAIM>
+size_t claim_all(size_t threads, CLAIM claim) {
+  atomic<size_t> claimed(0);
+  vector<thread> workers;
+  for (size_t t = 0; t < threads; ++t) {
+    workers.emplace_back([&claimed, &claim, t, threads]() {
+      size_t mine = 0;
+      size_t const start = t * (VISIT_BITS / threads);
+      for (size_t i = 0; i < VISIT_BITS; ++i) {
+        if (claim(((start + i) * STRIDE) & (VISIT_BITS - 1))) {
+          ++mine;
+        }
+      }
+      claimed += mine;
+    });
+  }
+  for (thread &w : workers) {
+    w.join();
+  }
+  return claimed;
+}
+
+} // namespace
+
+void bench_atomic_bitmap(size_t threads) {
+  cout << "visit " << VISIT_BITS << " bits by " << threads << " threads\n";
+  size_t const ops = VISIT_BITS * threads;
+
+  {
+    BitMap visit(VISIT_BITS);
+    mutex lock;
+    BenchClock::time_point const start = BenchClock::now();
+    size_t const claimed = claim_all(threads, [&](size_t pos) {
+      lock_guard<mutex> guard(lock);
+      if (visit.get(pos)) {
+        return false;
+      }
+      visit.set(pos);
+      return true;
+    });
+    report("  mutex BitMap", ops, elapsed(start));
+    if (claimed != VISIT_BITS) {
+      cout << "  wrong claims " << claimed << "\n";
+    }
+  }
+
+  {
+    AtomicBitMap visit(VISIT_BITS);
+    BenchClock::time_point const start = BenchClock::now();
+    size_t const claimed = claim_all(
+        threads, [&](size_t pos) { return !visit.test_and_set(pos); });
+    report("  AtomicBitMap acq_rel", ops, elapsed(start));
+    if (claimed != VISIT_BITS) {
+      cout << "  wrong claims " << claimed << "\n";
+    }
+  }
+
+  {
+    AtomicBitMap visit(VISIT_BITS);
+    BenchClock::time_point const start = BenchClock::now();
+    size_t const claimed = claim_all(threads, [&](size_t pos) {
+      // a cheap load first, most claims fail once the map fills up
+      return !visit.get(pos, memory_order_relaxed) &&
+             !visit.test_and_set(pos, memory_order_relaxed);
+    });
+    report("  AtomicBitMap relaxed", ops, elapsed(start));
+    if (claimed != VISIT_BITS) {
+      cout << "  wrong claims " << claimed << "\n";
+    }
+  }
+}
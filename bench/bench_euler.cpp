@@ -0,0 +1,56 @@
+#include <algorithm>
+#include <cstddef>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+#include "graph.h"
+#include "traveller.h"
+
+using namespace std;
+
+void bench_euler(size_t threads) {
+  for (size_t vertices : {100000, 1000000}) {
+    cout << "Euler tour of " << vertices
+         << " vertices, a ring and a random permutation\n";
+    mt19937 rng(1);
+    vector<VERTEX_ID> permutation(vertices);
+    for (size_t v = 0; v < vertices; ++v) {
+      permutation[v] = v;
+    }
+    shuffle(permutation.begin(), permutation.end(), rng);
+    Graph g;
+    g.init(vertices);
+    for (size_t v = 0; v < vertices; ++v) {
+      g.link(v, (v + 1) % vertices, 0);
+      g.link(v, permutation[v], 1);
+    }
+    g.scan();
+
+    auto traveller = IGraphTraveller::createInstance(IGraphTraveller::GT_EULER);
+    string trace;
+    BenchClock::time_point start = BenchClock::now();
+    traveller->travel(g, trace);
+    report("  into a string", g.getLinks().size(), elapsed(start));
+    cout << "  " << trace.size() << " bytes of string\n";
+
+    ofstream null("/dev/null");
+    start = BenchClock::now();
+    traveller->stream(g, null);
+    report("  streamed", g.getLinks().size(), elapsed(start));
+
+    // the closed trails found and spliced by the workers
+    for (size_t t : {size_t(1), threads}) {
+      auto parallel =
+          IGraphTraveller::createInstance(IGraphTraveller::GT_EULER);
+      parallel->configure({{"PARALLEL", static_cast<int>(t)}});
+      start = BenchClock::now();
+      parallel->stream(g, null);
+      report("  parallel, " + to_string(t) + " threads", g.getLinks().size(),
+             elapsed(start));
+    }
+  }
+}
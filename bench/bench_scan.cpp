@@ -0,0 +1,240 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <vector>
+
+#include "bench.h"
+#include "closure.h"
+#include "graph.h"
+#include "msbfs.h"
+
+using namespace std;
+
+namespace {
+
+// random graph, every vertex has degree out edges
+void random_graph(Graph &g, const size_t vertices, const size_t degree) {
+  mt19937 rng(1);
+  uniform_int_distribution<VERTEX_ID> target(0, vertices - 1);
+  g.init(vertices);
+  for (size_t v = 0; v < vertices; ++v) {
+    for (size_t e = 0; e < degree; ++e) {
+      g.link(v, target(rng), e);
+    }
+  }
+  g.freeze();
+}
+
+double scan(Graph &g, Graph::SCAN_METHOD method, size_t threads = 1) {
+  g.setScanMethod(method);
+  g.setScanThreads(threads);
+  BenchClock::time_point const start = BenchClock::now();
+  g.scan();
+  return elapsed(start);
+}
+
+bool same(const Graph &a, const Graph &b) {
+  for (VERTEX_ID i = 0; i < a.size(); ++i) {
+    for (VERTEX_ID j = 0; j < a.size(); ++j) {
+      if (a.reachable(i, j) != b.reachable(i, j)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+void bench_scan(size_t threads) {
+  for (size_t vertices : {1000, 4000}) {
+    for (size_t degree : {1, 3}) {
+      cout << "scan " << vertices << " vertices, " << degree
+           << " edges per vertex\n";
+      Graph bfs, closure, scc, msbfs;
+      random_graph(bfs, vertices, degree);
+      random_graph(closure, vertices, degree);
+      random_graph(scc, vertices, degree);
+      random_graph(msbfs, vertices, degree);
+
+      size_t const pairs = vertices * vertices;
+      report("  BFS", pairs, scan(bfs, Graph::SCAN_BFS));
+      report("  closure", pairs, scan(closure, Graph::SCAN_CLOSURE));
+      report("  SCC", pairs, scan(scc, Graph::SCAN_SCC));
+      report("  MS-BFS", pairs, scan(msbfs, Graph::SCAN_MSBFS));
+      if (threads > 1) {
+        cout << "  " << threads << " threads\n";
+        report("    BFS", pairs, scan(bfs, Graph::SCAN_BFS, threads));
+        report("    SCC", pairs, scan(scc, Graph::SCAN_SCC, threads));
+        report("    MS-BFS", pairs, scan(msbfs, Graph::SCAN_MSBFS, threads));
+      }
+      cout << "  " << scc.sccCount() << " components, table "
+           << scc.reachTable()->memory() << " bytes instead of "
+           << bfs.reachTable()->memory() << "\n";
+      if (!same(bfs, closure) || !same(bfs, scc) || !same(bfs, msbfs)) {
+        cout << "  different reachable tables\n";
+      }
+
+      BitMap2 adjacency(vertices, vertices);
+      for (Link *l : bfs.getLinks()) {
+        adjacency.set(l->source.id, l->target.id);
+      }
+      BenchClock::time_point const start = BenchClock::now();
+      BitMatrixClosure::warshall(adjacency);
+      report("  closure without blocking", pairs, elapsed(start));
+    }
+  }
+}
+
+void bench_distances(size_t) {
+  for (size_t vertices : {1000, 4000}) {
+    cout << "distances from all the " << vertices
+         << " vertices, 3 edges per vertex\n";
+    Graph g;
+    random_graph(g, vertices, 3);
+    vector<VERTEX_ID> sources;
+    for (VERTEX_ID v = 0; v < vertices; ++v) {
+      sources.push_back(v);
+    }
+    size_t const pairs = vertices * vertices;
+
+    // one BFS per source
+    BenchClock::time_point start = BenchClock::now();
+    vector<uint32_t> distance(vertices);
+    vector<VERTEX_ID> queue(vertices);
+    size_t checksum = 0;
+    for (VERTEX_ID const s : sources) {
+      fill(distance.begin(), distance.end(), MultiSourceBfs::UNREACHABLE);
+      size_t head = 0, tail = 0;
+      distance[s] = 0;
+      queue[tail++] = s;
+      while (head < tail) {
+        VERTEX_ID const v = queue[head++];
+        for (Link *l : g.getAdjacencies(v)) {
+          if (distance[l->target.id] == MultiSourceBfs::UNREACHABLE) {
+            distance[l->target.id] = distance[v] + 1;
+            queue[tail++] = l->target.id;
+          }
+        }
+      }
+      for (uint32_t d : distance) {
+        checksum += d;
+      }
+    }
+    report("  BFS per source", pairs, elapsed(start));
+
+    start = BenchClock::now();
+    MultiSourceBfs msbfs(g);
+    vector<vector<uint32_t>> distances;
+    msbfs.distances(sources, distances);
+    report("  MS-BFS", pairs, elapsed(start));
+    for (const vector<uint32_t> &row : distances) {
+      for (uint32_t d : row) {
+        checksum -= d;
+      }
+    }
+    if (checksum != 0) {
+      cout << "  different distances\n";
+    }
+  }
+}
+
+void bench_traverse(size_t) {
+  for (size_t vertices : {10000, 100000}) {
+    cout << "BFS from 100 sources, " << vertices
+         << " vertices, 4 edges per vertex\n";
+    Graph g;
+    random_graph(g, vertices, 4);
+
+    // the adjacency lists of Link pointers the graph kept before the CSR
+    vector<LinkList> net(vertices);
+    for (Link *l : g.getLinks()) {
+      net[l->source.id].push_back(l);
+    }
+    const CsrGraph &csr = g.csr();
+
+    vector<VERTEX_ID> queue(vertices);
+    vector<bool> seen(vertices);
+    size_t visits = 0;
+    auto bfs = [&queue, &seen, &visits](VERTEX_ID s, auto neighbours) {
+      fill(seen.begin(), seen.end(), false);
+      size_t head = 0, tail = 0;
+      seen[s] = true;
+      queue[tail++] = s;
+      while (head < tail) {
+        neighbours(queue[head++], [&](VERTEX_ID w) {
+          ++visits;
+          if (!seen[w]) {
+            seen[w] = true;
+            queue[tail++] = w;
+          }
+        });
+      }
+    };
+
+    BenchClock::time_point start = BenchClock::now();
+    for (VERTEX_ID s = 0; s < vertices; s += vertices / 100) {
+      bfs(s, [&net](VERTEX_ID v, auto next) {
+        for (Link *l : net[v]) {
+          next(l->target.id);
+        }
+      });
+    }
+    report("  link lists", visits, elapsed(start));
+
+    visits = 0;
+    start = BenchClock::now();
+    for (VERTEX_ID s = 0; s < vertices; s += vertices / 100) {
+      bfs(s, [&csr](VERTEX_ID v, auto next) {
+        for (uint32_t i = csr.begin(v); i < csr.end(v); ++i) {
+          next(csr.targets[i]);
+        }
+      });
+    }
+    report("  CSR", visits, elapsed(start));
+
+    size_t const links = g.getLinks().size();
+    cout << "  CSR " << csr.memory() << " bytes, link lists "
+         << vertices * sizeof(LinkList) + links * sizeof(Link *)
+         << " bytes and " << links * (sizeof(Link) + sizeof(Edge))
+         << " bytes of Link and Edge\n";
+  }
+}
+
+void bench_eulerize(size_t) {
+  for (size_t vertices : {1000, 4000}) {
+    cout << "eulerize " << vertices
+         << " vertices on a ring, 2 more edges per vertex\n";
+    // the ring keeps the graph strongly connected, so it can be balanced
+    mt19937 rng(1);
+    uniform_int_distribution<VERTEX_ID> target(0, vertices - 1);
+    Graph g;
+    g.init(vertices);
+    for (size_t v = 0; v < vertices; ++v) {
+      g.link(v, (v + 1) % vertices, 0);
+      g.link(v, target(rng), 1);
+      g.link(v, target(rng), 2);
+    }
+    g.scan();
+
+    // eulerize dumps the graph, keep it out of the report
+    ostringstream sink;
+    streambuf *const out = cout.rdbuf(sink.rdbuf());
+    BenchClock::time_point const start = BenchClock::now();
+    g.eulerize();
+    double const seconds = elapsed(start);
+    cout.rdbuf(out);
+
+    size_t walks = 0;
+    for (uint32_t const m : g.multiplicities()) {
+      walks += m;
+    }
+    report("  transportation", g.getLinks().size(), seconds);
+    cout << "  " << (g.eulerian() ? "eulerian" : "not eulerian") << ", "
+         << walks - g.getLinks().size() << " walks added to "
+         << g.getLinks().size() << " links\n";
+  }
+}
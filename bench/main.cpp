@@ -0,0 +1,57 @@
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "bench.h"
+
+using namespace std;
+
+namespace {
+
+struct Benchmark {
+  const char *name;
+  void (*run)(size_t threads);
+};
+
+const Benchmark BENCHMARKS[] = {
+    {"atomic_bitmap", bench_atomic_bitmap},
+    {"scan", bench_scan},
+    {"distances", bench_distances},
+    {"traverse", bench_traverse},
+    {"arena", bench_arena},
+    {"eulerize", bench_eulerize},
+    {"euler", bench_euler},
+    {"bfs_all", bench_bfs_all},
+};
+
+} // namespace
+
+// casegen_bench [-t threads] [benchmark ...]
+int main(int argc, char *argv[]) {
+  size_t threads = thread::hardware_concurrency();
+  if (threads == 0) {
+    threads = 1;
+  }
+
+  bool all = true;
+  for (int i = 1; i < argc; ++i) {
+    if (string("-t") == argv[i] && i + 1 < argc) {
+      threads = atoi(argv[++i]);
+      continue;
+    }
+    all = false;
+  }
+
+  for (const Benchmark &b : BENCHMARKS) {
+    bool selected = all;
+    for (int i = 1; i < argc && !selected; ++i) {
+      selected = (strcmp(argv[i], b.name) == 0);
+    }
+    if (selected) {
+      b.run(threads);
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,75 @@
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <arena.h>
+#include <graph.h>
+#include <gtest/gtest.h>
+
+namespace {
+// counts the live objects
+struct Counted {
+  static int alive;
+  std::string name;
+  explicit Counted(const std::string &n) : name(n) { ++alive; };
+  ~Counted() { --alive; };
+};
+int Counted::alive = 0;
+} // namespace
+
+TEST(Arena, create) {
+  Arena arena(256);
+  std::vector<Counted *> objects;
+  for (int i = 0; i < 100; ++i) {
+    objects.push_back(arena.create<Counted>(std::to_string(i)));
+    // trivially destructible, no destructor record
+    *arena.create<double>() = i;
+  }
+  EXPECT_EQ(Counted::alive, 100);
+  EXPECT_GT(arena.blocks(), 1);
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_EQ(objects[i]->name, std::to_string(i));
+  }
+
+  arena.reset();
+  EXPECT_EQ(Counted::alive, 0);
+  EXPECT_EQ(arena.blocks(), 0);
+  EXPECT_EQ(arena.memory(), 0);
+
+  // usable again after a reset, and destroyed with the arena
+  {
+    Arena other;
+    other.create<Counted>("a");
+    arena.create<Counted>("b");
+    EXPECT_EQ(Counted::alive, 2);
+  }
+  EXPECT_EQ(Counted::alive, 1);
+}
+
+TEST(Arena, allocate) {
+  Arena arena(64);
+  for (size_t align : {1, 2, 4, 8, 16}) {
+    void *p = arena.allocate(3, align);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(p) % align, 0);
+  }
+  // bigger than a block
+  char *big = static_cast<char *>(arena.allocate(1000));
+  big[999] = 1;
+  EXPECT_GE(arena.memory(), 1000);
+}
+
+TEST(Arena, graph) {
+  // a graph can be built again, the old elements go with the arena
+  Graph g;
+  for (size_t round = 0; round < 3; ++round) {
+    g.init(10);
+    for (VERTEX_ID v = 0; v < 10; ++v) {
+      g.link(v, (v + 1) % 10, 0);
+      g.link(v, (v + 3) % 10, 1);
+    }
+    g.scan();
+    EXPECT_EQ(g.getLinks().size(), 20);
+    EXPECT_TRUE(g.good());
+    EXPECT_TRUE(g.reachable(0, 9));
+  }
+}
@@ -1,10 +1,21 @@
+#include <atomic>
 #include <cstddef>
+#include <random>
 #include <stdexcept>
+#include <thread>
 #include <vector>
 
+#include <atomic_bitmap.h>
 #include <bitmap.h>
+#include <bitmap_kernel.h>
 #include <gtest/gtest.h>
 
+namespace {
+const BitMapKernel::ISA ALL_ISA[] = {BitMapKernel::ISA_SCALAR,
+                                     BitMapKernel::ISA_SSE2,
+                                     BitMapKernel::ISA_AVX2};
+}
+
 TEST(BitMap, create) {
   BitMap const bitmap(10);
 
@@ -217,6 +228,143 @@ TEST(BitMap, diff) {
 
   BitMap bm3(size / 2);
   EXPECT_THROW(bm1.diff(bm3, bit_diff), std::logic_error);
+
+  EXPECT_EQ(2, bm1.count_diff(bm2));
+  EXPECT_EQ((bm1 ^ bm2).count(), bm1.count_diff(bm2));
+  EXPECT_EQ(0, bm1.count_diff(bm1));
+  EXPECT_THROW(bm1.count_diff(bm3), std::logic_error);
+}
+
+TEST(BitMap, value_operators) {
+  const size_t size = 999;
+  BitMap bm1(size);
+  BitMap bm2(size);
+  BitMap bm3(size);
+  bm1.set(1);
+  bm2.set(2);
+  bm3.set(1);
+  bm3.set(3);
+
+  // the operators return new bit maps and leave the operands unchanged
+  BitMap bm4 = bm1 | bm2 | bm3;
+  EXPECT_EQ(3, bm4.count());
+  EXPECT_EQ(1, bm1.count());
+  BitMap bm5 = (bm1 | bm2) & bm3;
+  EXPECT_EQ(1, bm5.count());
+  EXPECT_TRUE(bm5.get(1));
+  BitMap bm6 = (bm1 ^ bm3) ^ bm2;
+  EXPECT_EQ(2, bm6.count());
+  EXPECT_TRUE(bm6.get(2));
+  EXPECT_TRUE(bm6.get(3));
+
+  // moved from bit map is empty
+  BitMap bm7 = std::move(bm6);
+  EXPECT_EQ(size, bm7.size());
+  EXPECT_EQ(0, bm6.size());
+  bm6 = bm7;
+  EXPECT_TRUE(bm6 == bm7);
+}
+
+TEST(BitMap, inline_storage) {
+  const size_t small = BitMap::INLINE_BLOCKS * MARKER_BLOCK_BITS;
+  const size_t big = small + 1;
+  for (size_t size : {size_t(0), size_t(1), small, big, 3 * big}) {
+    BitMap bm(size);
+    bm.set(0);
+    bm.set(size - 1);
+    BitMap copy(bm);
+    EXPECT_TRUE(copy == bm);
+
+    // moved bits keep their value whatever the storage
+    BitMap moved(std::move(copy));
+    EXPECT_TRUE(moved == bm);
+    EXPECT_EQ(0, copy.size());
+    copy = std::move(moved);
+    EXPECT_TRUE(copy == bm);
+
+    // copy between the inline and the heap storage
+    BitMap other(size == small ? big : small);
+    other = bm;
+    EXPECT_TRUE(other == bm);
+
+    // reused storage is cleared
+    for (size_t n : {size, small, big}) {
+      other.set();
+      other.assign(n);
+      EXPECT_EQ(n, other.size());
+      EXPECT_TRUE(other.all0());
+      other.set();
+      EXPECT_EQ(n, other.count());
+    }
+  }
+}
+
+TEST(BitMap, block_boundary) {
+  for (size_t size : {MARKER_BLOCK_BITS - 1, MARKER_BLOCK_BITS,
+                      MARKER_BLOCK_BITS + 1, 3 * MARKER_BLOCK_BITS}) {
+    BitMap bm(size);
+    EXPECT_EQ(0, bm.count());
+
+    bm.set();
+    EXPECT_TRUE(bm.all1());
+    EXPECT_EQ(size, bm.count());
+
+    // the bits beyond size are not part of the bit map
+    BitMap big(size + 1);
+    big.set();
+    bm |= big;
+    EXPECT_EQ(size, bm.count());
+    bm ^= big;
+    EXPECT_TRUE(bm.all0());
+
+    bm.set(size - 1);
+    EXPECT_EQ(1, bm.count());
+    EXPECT_FALSE(bm.all0());
+    EXPECT_FALSE(bm.all1());
+  }
+}
+
+TEST(BitMap, find) {
+  const size_t size = 3 * MARKER_BLOCK_BITS + 5;
+  BitMap bm(size);
+  EXPECT_EQ(BitMap::npos, bm.find_first());
+  EXPECT_EQ(0, bm.find_first_unset());
+
+  const std::vector<size_t> bits = {0, 1, 63, 64, 130, size - 1};
+  for (auto pos : bits) {
+    bm.set(pos);
+  }
+  EXPECT_EQ(bits.size(), bm.count());
+
+  std::vector<size_t> found;
+  for (size_t pos = bm.find_first(); pos != BitMap::npos;
+       pos = bm.find_next(pos)) {
+    found.push_back(pos);
+  }
+  EXPECT_EQ(bits, found);
+
+  found.clear();
+  for (auto pos : bm.set_bits()) {
+    found.push_back(pos);
+  }
+  EXPECT_EQ(bits, found);
+
+  size_t unset = 0;
+  for (auto pos : bm.unset_bits()) {
+    EXPECT_FALSE(bm.get(pos));
+    ++unset;
+  }
+  EXPECT_EQ(size - bits.size(), unset);
+  EXPECT_EQ(2, bm.find_first_unset());
+  EXPECT_EQ(65, bm.find_next_unset(63));
+
+  // the bits beyond size are never reported
+  bm.set();
+  EXPECT_EQ(BitMap::npos, bm.find_first_unset());
+  EXPECT_EQ(BitMap::npos, bm.find_next(size - 1));
+  bm.reset(size - 1);
+  EXPECT_EQ(size - 1, bm.find_first_unset());
+  EXPECT_EQ(BitMap::npos, bm.find_next_unset(size - 1));
 }
 
 TEST(BitMap2, create) {
@@ -373,6 +521,50 @@ TEST(BitMap2, compare_different_size) {
   EXPECT_TRUE(bm2 <= bm1);
 }
 
+TEST(BitMap2, row_view) {
+  const size_t row = 77;
+  const size_t col = 99;
+  BitMap2 bm(row, col);
+
+  // rows are written in place through the views
+  bm.row(3).set(5);
+  bm.row(4).set(98);
+  EXPECT_TRUE(bm.get(3, 5));
+  EXPECT_TRUE(bm.get(4, 98));
+  EXPECT_EQ(col, bm[3].size());
+  EXPECT_EQ(1, bm[3].count());
+
+  bm.row(3) |= bm[4];
+  EXPECT_TRUE(bm.get(3, 98));
+  EXPECT_EQ(2, bm[3].count());
+  EXPECT_TRUE(bm[3] >= bm[4]);
+  EXPECT_FALSE(bm[4] >= bm[3]);
+  EXPECT_TRUE(bm[4] <= bm[3]);
+
+  bm.row(4) &= bm[3];
+  EXPECT_TRUE(bm.get(4, 98));
+  EXPECT_FALSE(bm.get(4, 5));
+
+  bm.row(5).set();
+  EXPECT_TRUE(bm[5].all1());
+  EXPECT_EQ(col, bm[5].count());
+  EXPECT_FALSE(bm.get(6, 0)); // the padding does not leak to the next row
+  bm.row(5).reset();
+  EXPECT_TRUE(bm[5].all0());
+
+  // a bit map can be viewed as a row
+  BitMap line(col);
+  line.set(5);
+  line.set(98);
+  EXPECT_TRUE(line.view() == bm[3]);
+  bm.row(6) |= line.view();
+  EXPECT_TRUE(bm[6] == bm[3]);
+
+  BitMap other(col + 1);
+  EXPECT_THROW(bm.row(6) |= other.view(), std::out_of_range);
+  EXPECT_THROW(bm.row(row), std::out_of_range);
+}
+
 TEST(BitMap2, exception) {
   const size_t row = 77;
   const size_t col = 99;
@@ -386,3 +578,159 @@ TEST(BitMap2, exception) {
   EXPECT_THROW(bm1 &= bm2, std::out_of_range);
   EXPECT_THROW(bm1 |= bm2, std::out_of_range);
 }
+
+TEST(BitMapKernel, equivalence) {
+  const BitMapKernel *scalar = BitMapKernel::select(BitMapKernel::ISA_SCALAR);
+  ASSERT_NE(nullptr, scalar);
+
+  std::mt19937_64 rand(20221017);
+  for (auto isa : ALL_ISA) {
+    const BitMapKernel *kernel = BitMapKernel::select(isa);
+    if (nullptr == kernel) {
+      continue; // not supported by this cpu
+    }
+
+    for (size_t len = 0; len < 67; ++len) {
+      std::vector<MARKER_BLOCK> a(len);
+      std::vector<MARKER_BLOCK> b(len);
+      for (size_t i = 0; i < len; ++i) {
+        a[i] = rand();
+        b[i] = rand();
+      }
+
+      // binary operators
+      std::vector<MARKER_BLOCK> x = a;
+      std::vector<MARKER_BLOCK> y = a;
+      kernel->and_blocks(x.data(), b.data(), len);
+      scalar->and_blocks(y.data(), b.data(), len);
+      EXPECT_EQ(x, y) << kernel->name;
+      x = a;
+      y = a;
+      kernel->or_blocks(x.data(), b.data(), len);
+      scalar->or_blocks(y.data(), b.data(), len);
+      EXPECT_EQ(x, y) << kernel->name;
+      x = a;
+      y = a;
+      kernel->xor_blocks(x.data(), b.data(), len);
+      scalar->xor_blocks(y.data(), b.data(), len);
+      EXPECT_EQ(x, y) << kernel->name;
+
+      // compare and count, make the difference in every position
+      EXPECT_EQ(scalar->count(a.data(), len), kernel->count(a.data(), len));
+      EXPECT_EQ(scalar->count_xor(a.data(), b.data(), len),
+                kernel->count_xor(a.data(), b.data(), len));
+      EXPECT_TRUE(kernel->equal(a.data(), a.data(), len));
+      std::vector<MARKER_BLOCK> ab = a;
+      scalar->or_blocks(ab.data(), b.data(), len);
+      EXPECT_TRUE(kernel->subset(a.data(), ab.data(), len));
+      std::vector<MARKER_BLOCK> zeros(len, 0);
+      std::vector<MARKER_BLOCK> ones(len, ~static_cast<MARKER_BLOCK>(0));
+      EXPECT_TRUE(kernel->all0(zeros.data(), len));
+      EXPECT_TRUE(kernel->all1(ones.data(), len));
+      for (size_t i = 0; i < len; ++i) {
+        x = a;
+        x[i] ^= static_cast<MARKER_BLOCK>(1) << (i % MARKER_BLOCK_BITS);
+        EXPECT_FALSE(kernel->equal(a.data(), x.data(), len)) << kernel->name;
+        EXPECT_EQ(scalar->subset(x.data(), a.data(), len),
+                  kernel->subset(x.data(), a.data(), len))
+            << kernel->name;
+        zeros[i] = 1;
+        EXPECT_FALSE(kernel->all0(zeros.data(), len)) << kernel->name;
+        zeros[i] = 0;
+        ones[i] = ~static_cast<MARKER_BLOCK>(2);
+        EXPECT_FALSE(kernel->all1(ones.data(), len)) << kernel->name;
+        ones[i] = ~static_cast<MARKER_BLOCK>(0);
+      }
+    }
+  }
+}
+
+TEST(BitMapKernel, bitmap_operators) {
+  const BitMapKernel::ISA isa = BitMapKernel::active().isa;
+  for (auto forced : ALL_ISA) {
+    if (!BitMapKernel::use(forced)) {
+      continue;
+    }
+
+    const size_t row = 77;
+    const size_t col = 99;
+    BitMap2 bm1(row, col);
+    BitMap2 bm2(row, col);
+    bm1.set();
+    EXPECT_TRUE(bm1.all1());
+    EXPECT_FALSE(bm1.all0());
+    EXPECT_EQ(row * col, bm1.size());
+    bm2.set(10, 30);
+    EXPECT_TRUE(bm1 > bm2);
+    EXPECT_TRUE(bm2 < bm1);
+    bm1 &= bm2;
+    EXPECT_TRUE(bm1 == bm2);
+    bm2.set(20, 40);
+    bm1 |= bm2;
+    EXPECT_TRUE(bm1 == bm2);
+
+    BitMap bm3(1000);
+    BitMap bm4(1000);
+    bm3.set(999);
+    bm4.set(1);
+    bm4 ^= bm3;
+    EXPECT_EQ(2, bm4.count());
+    EXPECT_TRUE(bm4 >= bm3);
+    EXPECT_FALSE(bm3 >= bm4);
+  }
+  BitMapKernel::use(isa);
+}
+
+TEST(AtomicBitMap, set_get) {
+  const size_t size = 999;
+  AtomicBitMap bm(size);
+  EXPECT_EQ(size, bm.size());
+  EXPECT_EQ(0, bm.count());
+
+  EXPECT_FALSE(bm.test_and_set(10));
+  EXPECT_TRUE(bm.test_and_set(10));
+  EXPECT_TRUE(bm.get(10));
+  EXPECT_TRUE(bm[10]);
+  bm.set(998, std::memory_order_relaxed);
+  bm.set(999); // out of range, ignored
+  EXPECT_EQ(2, bm.count());
+
+  BitMap snapshot = bm.snapshot();
+  EXPECT_EQ(size, snapshot.size());
+  EXPECT_EQ(2, snapshot.count());
+  EXPECT_TRUE(snapshot.get(10));
+  EXPECT_TRUE(snapshot.get(998));
+
+  EXPECT_TRUE(bm.test_and_reset(10));
+  EXPECT_FALSE(bm.test_and_reset(10));
+  bm.reset(998);
+  EXPECT_EQ(0, bm.count());
+  bm.snapshot(snapshot);
+  EXPECT_TRUE(snapshot.all0());
+}
+
+TEST(AtomicBitMap, concurrent_claim) {
+  const size_t size = 100000;
+  const size_t threads = 4;
+  AtomicBitMap bm(size);
+  std::atomic<size_t> claimed(0);
+
+  // every position is claimed by exactly one thread
+  std::vector<std::thread> workers;
+  for (size_t t = 0; t < threads; ++t) {
+    workers.emplace_back([&bm, &claimed, t]() {
+      for (size_t i = 0; i < size; ++i) {
+        if (!bm.test_and_set((i + t * 7919) % size)) {
+          ++claimed;
+        }
+      }
+    });
+  }
+  for (auto &w : workers) {
+    w.join();
+  }
+
+  EXPECT_EQ(size, claimed);
+  EXPECT_EQ(size, bm.count());
+  EXPECT_TRUE(bm.snapshot().all1());
+}
@@ -0,0 +1,89 @@
+#include <cstddef>
+#include <queue>
+#include <random>
+#include <stdexcept>
+
+#include <bitmap.h>
+#include <closure.h>
+#include <gtest/gtest.h>
+
+namespace {
+// random adjacency matrix with about degree edges per vertex
+BitMap2 random_graph(const size_t n, const double degree, std::mt19937 &rng) {
+  BitMap2 m(n, n);
+  std::uniform_real_distribution<double> p(0, 1);
+  for (size_t i = 0; i < n; ++i) {
+    for (size_t j = 0; j < n; ++j) {
+      if (p(rng) * n < degree) {
+        m.set(i, j);
+      }
+    }
+  }
+  return m;
+}
+
+// reachable by one or more edges, one BFS per vertex
+BitMap2 reference(const BitMap2 &m) {
+  const size_t n = m.rows();
+  BitMap2 r(n, n);
+  for (size_t v = 0; v < n; ++v) {
+    std::queue<size_t> q;
+    q.push(v);
+    while (!q.empty()) {
+      size_t const w = q.front();
+      q.pop();
+      for (size_t x = 0; x < n; ++x) {
+        if (m.get(w, x) && !r.get(v, x)) {
+          r.set(v, x);
+          q.push(x);
+        }
+      }
+    }
+  }
+  return r;
+}
+} // namespace
+
+TEST(BitMatrixClosure, same_as_bfs) {
+  std::mt19937 rng(3);
+  for (size_t n : {0, 1, 2, 7, 8, 9, 63, 64, 65, 130}) {
+    for (double degree : {0.5, 1.0, 3.0}) {
+      const BitMap2 m = random_graph(n, degree, rng);
+      const BitMap2 expected = reference(m);
+
+      BitMap2 w(m);
+      BitMatrixClosure::warshall(w);
+      EXPECT_TRUE(w == expected) << "n=" << n << " degree=" << degree;
+
+      BitMap2 f(m);
+      BitMatrixClosure::fourRussians(f);
+      EXPECT_TRUE(f == expected) << "n=" << n << " degree=" << degree;
+    }
+  }
+}
+
+TEST(BitMatrixClosure, chain) {
+  // 0 -> 1 -> ... -> n-1 -> 0 crosses all the pivot blocks backwards
+  const size_t n = 37;
+  BitMap2 m(n, n);
+  for (size_t i = 0; i < n; ++i) {
+    m.set(i, (i + 1) % n);
+  }
+  BitMatrixClosure::fourRussians(m);
+  EXPECT_TRUE(m.all1());
+
+  BitMap2 open(n, n);
+  for (size_t i = n - 1; i > 0; --i) {
+    open.set(i, i - 1);
+  }
+  BitMatrixClosure::fourRussians(open);
+  for (size_t i = 0; i < n; ++i) {
+    EXPECT_EQ(i, open[i].count());
+  }
+}
+
+TEST(BitMatrixClosure, exception) {
+  BitMap2 m(3, 4);
+  EXPECT_THROW(BitMatrixClosure::warshall(m), std::logic_error);
+  EXPECT_THROW(BitMatrixClosure::fourRussians(m), std::logic_error);
+}
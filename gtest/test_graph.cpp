@@ -1,8 +1,20 @@
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
+#include <random>
+#include <set>
+#include <sstream>
+#include <stdexcept>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include <gtest/gtest.h>
 
+#include <case_sink.h>
 #include <graph.h>
 #include <traveller.h>
 
@@ -54,6 +66,744 @@ TEST_F(GraphTest, Scan) {
   EXPECT_TRUE(graph().reachable(1, 1));
 }
 
+TEST_F(GraphTest, ScanSparse) {
+  Graph sparse;
+  sparse.setReachPolicy(Graph::RP_SPARSE);
+  sparse.loadFromFile("test_matrix.txt");
+  EXPECT_EQ(sparse.reachPolicy(), Graph::RP_SPARSE);
+  for (VERTEX_ID i = 0; i < graph().size(); ++i) {
+    for (VERTEX_ID j = 0; j < graph().size(); ++j) {
+      ASSERT_EQ(sparse.reachable(i, j), graph().reachable(i, j));
+    }
+  }
+
+  // switching the policy of a scanned graph scans it again
+  graph().setReachPolicy(Graph::RP_SPARSE);
+  EXPECT_TRUE(graph().reachable(10, 53));
+  EXPECT_TRUE(graph().reachable(52, 1));
+
+  GraphTravellerBfsOne traveller;
+  traveller.configure({{"START", 10}, {"END", 53}});
+  MemorySink path;
+  traveller.travel(sparse, path);
+  ASSERT_EQ(path.cases().size(), 1);
+  EXPECT_EQ(sparse.getLink(path.cases()[0].links.back())->target.id, 53);
+}
+
+TEST_F(GraphTest, ScanClosure) {
+  Graph closure;
+  closure.setScanMethod(Graph::SCAN_CLOSURE);
+  closure.loadFromFile("test_matrix.txt");
+  EXPECT_EQ(closure.scanMethod(), Graph::SCAN_CLOSURE);
+  for (VERTEX_ID i = 0; i < graph().size(); ++i) {
+    for (VERTEX_ID j = 0; j < graph().size(); ++j) {
+      ASSERT_EQ(closure.reachable(i, j), graph().reachable(i, j));
+    }
+  }
+}
+
+TEST_F(GraphTest, Scc) {
+  EXPECT_EQ(graph().scanMethod(), Graph::SCAN_SCC);
+  EXPECT_GT(graph().sccCount(), 0);
+  EXPECT_LE(graph().sccCount(), graph().size());
+
+  // the links go down the component ids, the vertices of a component share
+  // the reachable row
+  for (Link *l : graph().getLinks()) {
+    size_t const from = graph().sccId(l->source.id);
+    size_t const to = graph().sccId(l->target.id);
+    EXPECT_GE(from, to);
+    if (from == to) {
+      EXPECT_TRUE(graph().reachable(l->source.id, l->source.id));
+      EXPECT_EQ(graph().reachRow(l->source.id),
+                graph().reachRow(l->target.id));
+    }
+  }
+  for (size_t c = 0; c < graph().sccCount(); ++c) {
+    for (size_t const to : graph().sccSuccessors(c)) {
+      EXPECT_LT(to, c);
+    }
+    for (VERTEX_ID const v : graph().sccMembers(c)) {
+      EXPECT_EQ(graph().sccId(v), c);
+    }
+  }
+}
+
+TEST(GraphCsr, freeze) {
+  const size_t vertices = 50;
+  std::mt19937 rng(3);
+  std::uniform_int_distribution<VERTEX_ID> vertex(0, vertices - 1);
+  Graph g;
+  g.init(vertices);
+  for (size_t e = 0; e < 3 * vertices; ++e) {
+    g.link(vertex(rng), vertex(rng), e % 4);
+  }
+  EXPECT_FALSE(g.frozen());
+  EXPECT_THROW(g.csr(), std::logic_error);
+
+  g.freeze();
+  const CsrGraph &csr = g.csr();
+  ASSERT_EQ(csr.vertices(), vertices);
+  ASSERT_EQ(csr.links(), g.getLinks().size());
+  // the links of a vertex in the order they were linked
+  std::vector<std::vector<Link *>> expected(vertices);
+  for (Link *l : g.getLinks()) {
+    expected[l->source.id].push_back(l);
+  }
+  for (VERTEX_ID v = 0; v < vertices; ++v) {
+    ASSERT_EQ(csr.degree(v), expected[v].size());
+    ASSERT_EQ(g.getAdjacencies(v).size(), expected[v].size());
+    std::vector<Link *> const adj(g.getAdjacencies(v).begin(),
+                                  g.getAdjacencies(v).end());
+    EXPECT_EQ(adj, expected[v]);
+    for (uint32_t i = csr.begin(v); i < csr.end(v); ++i) {
+      Link *l = expected[v][i - csr.begin(v)];
+      EXPECT_EQ(csr.targets[i], l->target.id);
+      EXPECT_EQ(csr.edge_ids[i], l->edge.id);
+      EXPECT_EQ(csr.edge_types[i], l->edge.type);
+    }
+  }
+
+  // the reverse index has every link once, under its target
+  std::vector<uint32_t> entering;
+  for (VERTEX_ID v = 0; v < vertices; ++v) {
+    for (uint32_t k = csr.rbegin(v); k < csr.rend(v); ++k) {
+      uint32_t const i = csr.rev_links[k];
+      EXPECT_EQ(csr.targets[i], v);
+      VERTEX_ID const source = csr.rev_sources[k];
+      EXPECT_EQ(g.getLink(csr.edge_ids[i])->source.id, source);
+      EXPECT_GE(i, csr.begin(source));
+      EXPECT_LT(i, csr.end(source));
+      entering.push_back(i);
+    }
+  }
+  std::sort(entering.begin(), entering.end());
+  for (uint32_t i = 0; i < entering.size(); ++i) {
+    EXPECT_EQ(entering[i], i);
+  }
+
+  // a new link needs a new freeze
+  g.link(0, 1, 0);
+  EXPECT_THROW(g.getAdjacencies(0), std::logic_error);
+  g.freeze();
+  EXPECT_EQ(g.getAdjacencies(0).size(), expected[0].size() + 1);
+}
+
+TEST(GraphEuler, tour) {
+  // a ring and a random permutation, balanced and strongly connected
+  const size_t vertices = 20000;
+  std::mt19937 rng(17);
+  std::vector<VERTEX_ID> permutation(vertices);
+  for (VERTEX_ID v = 0; v < vertices; ++v) {
+    permutation[v] = v;
+  }
+  std::shuffle(permutation.begin(), permutation.end(), rng);
+  Graph g;
+  g.init(vertices);
+  for (VERTEX_ID v = 0; v < vertices; ++v) {
+    g.link(v, (v + 1) % vertices, 0);
+    g.link(v, permutation[v], 1);
+  }
+  g.scan();
+  ASSERT_TRUE(g.eulerian());
+
+  auto pTraveller = IGraphTraveller::createInstance(IGraphTraveller::GT_EULER);
+  std::string trace;
+  pTraveller->travel(g, trace);
+  std::ostringstream out;
+  pTraveller->stream(g, out);
+  EXPECT_EQ(out.str(), trace);
+
+  // the vertices of the tour, every link walked once from S0 back to S0
+  std::vector<std::string> steps;
+  for (size_t pos = 0; pos != std::string::npos;) {
+    size_t const next = trace.find("--", pos);
+    steps.push_back(trace.substr(pos, next - pos));
+    pos = (next == std::string::npos) ? next : trace.find("-->", next) + 3;
+  }
+  ASSERT_EQ(steps.size(), 2 * vertices + 1);
+  EXPECT_EQ(steps.front(), "S0");
+  EXPECT_EQ(steps.back(), "S0");
+  std::multiset<std::pair<std::string, std::string>> walked, expected;
+  for (size_t i = 1; i < steps.size(); ++i) {
+    walked.emplace(steps[i - 1], steps[i]);
+  }
+  for (Link *l : g.getLinks()) {
+    expected.emplace(l->source.name(), l->target.name());
+  }
+  EXPECT_EQ(walked, expected);
+}
+
+TEST(GraphEuler, parallel) {
+  // a ring, a random permutation and a few chords, eulerized so some links
+  // are walked more than once
+  const size_t vertices = 5000;
+  std::mt19937 rng(19);
+  std::vector<VERTEX_ID> permutation(vertices);
+  for (VERTEX_ID v = 0; v < vertices; ++v) {
+    permutation[v] = v;
+  }
+  std::shuffle(permutation.begin(), permutation.end(), rng);
+  Graph g;
+  g.init(vertices);
+  for (VERTEX_ID v = 0; v < vertices; ++v) {
+    g.link(v, (v + 1) % vertices, 0);
+    g.link(v, permutation[v], 1);
+  }
+  std::uniform_int_distribution<VERTEX_ID> vertex(0, vertices - 1);
+  for (int chord = 0; chord < 3; ++chord) {
+    g.link(vertex(rng), vertex(rng), 2);
+  }
+  g.scan();
+  g.eulerize();
+  ASSERT_TRUE(g.eulerian());
+
+  std::multiset<std::pair<std::string, std::string>> expected;
+  size_t walks = 0;
+  for (LINK_ID e = 0; e < g.getLinks().size(); ++e) {
+    const Link *l = g.getLink(e);
+    for (uint32_t m = 0; m < g.multiplicity(e); ++m) {
+      expected.emplace(l->source.name(), l->target.name());
+    }
+    walks += g.multiplicity(e);
+  }
+  ASSERT_GT(walks, g.getLinks().size());
+
+  std::string first;
+  for (int threads : {1, 2, 4}) {
+    auto pTraveller =
+        IGraphTraveller::createInstance(IGraphTraveller::GT_EULER);
+    pTraveller->configure({{"PARALLEL", threads}});
+    std::ostringstream out;
+    pTraveller->stream(g, out);
+    std::string const trace = out.str();
+
+    std::vector<std::string> steps;
+    for (size_t pos = 0; pos != std::string::npos;) {
+      size_t const next = trace.find("--", pos);
+      steps.push_back(trace.substr(pos, next - pos));
+      pos = (next == std::string::npos) ? next : trace.find("-->", next) + 3;
+    }
+    ASSERT_EQ(steps.size(), walks + 1);
+    EXPECT_EQ(steps.front(), "S0");
+    EXPECT_EQ(steps.back(), "S0");
+    std::multiset<std::pair<std::string, std::string>> walked;
+    for (size_t i = 1; i < steps.size(); ++i) {
+      walked.emplace(steps[i - 1], steps[i]);
+    }
+    EXPECT_EQ(walked, expected);
+
+    // the same tour whatever the threads
+    if (first.empty()) {
+      first = trace;
+    }
+    EXPECT_EQ(trace, first);
+  }
+}
+
+TEST(GraphEuler, split) {
+  // a ring of rings, the start far from most of the links
+  const size_t rings = 8, size = 50;
+  Graph g;
+  g.init(rings * size);
+  for (VERTEX_ID r = 0; r < rings; ++r) {
+    for (VERTEX_ID v = 0; v < size; ++v) {
+      g.link(r * size + v, r * size + (v + 1) % size, 0);
+    }
+    g.link(r * size, ((r + 1) % rings) * size, 1);
+    g.link(((r + 1) % rings) * size, r * size, 2);
+  }
+  g.scan();
+  ASSERT_TRUE(g.eulerian());
+  std::set<std::pair<std::string, std::string>> links;
+  for (Link *l : g.getLinks()) {
+    links.emplace(l->source.name(), l->target.name());
+  }
+
+  auto pTraveller = IGraphTraveller::createInstance(IGraphTraveller::GT_EULER);
+  std::string tour;
+  pTraveller->travel(g, tour);
+  pTraveller->configure({{"SPLIT", 1}});
+  std::string trace;
+  pTraveller->travel(g, trace);
+  EXPECT_EQ(trace, tour);
+
+  const size_t walks = g.getLinks().size();
+  for (int pieces : {2, 4, 7}) {
+    pTraveller->configure({{"SPLIT", pieces}});
+    pTraveller->travel(g, trace);
+
+    std::vector<std::string> cases;
+    std::istringstream in(trace);
+    for (std::string line; std::getline(in, line);) {
+      cases.push_back(line);
+    }
+    ASSERT_GE(cases.size(), 2);
+    ASSERT_LE(cases.size(), pieces);
+
+    // every case is a path from S0, every link is in some case
+    std::set<std::pair<std::string, std::string>> walked;
+    size_t longest = 0;
+    for (const std::string &c : cases) {
+      std::vector<std::string> steps;
+      for (size_t pos = 0; pos != std::string::npos;) {
+        size_t const next = c.find("--", pos);
+        steps.push_back(c.substr(pos, next - pos));
+        pos = (next == std::string::npos) ? next : c.find("-->", next) + 3;
+      }
+      EXPECT_EQ(steps.front(), "S0");
+      for (size_t i = 1; i < steps.size(); ++i) {
+        EXPECT_EQ(links.count(std::make_pair(steps[i - 1], steps[i])), 1);
+        walked.emplace(steps[i - 1], steps[i]);
+      }
+      longest = std::max(longest, steps.size() - 1);
+    }
+    EXPECT_EQ(walked, links);
+    // no longer than an even cut with the longest reset, around the hubs
+    // then around a ring
+    EXPECT_LE(longest, (walks + pieces - 1) / pieces + rings / 2 + size - 1);
+    EXPECT_LT(longest, walks);
+  }
+}
+
+namespace {
+
+// the paths from start to end GraphTravellerBfsAll finds, by a plain
+// exhaustive search without pruning
+struct AllPaths {
+  const CsrGraph &csr;
+  VERTEX_ID start, end;
+  size_t max_depth, max_cases;
+  std::vector<bool> visited;
+  bool strict = false; // the depth limited before the first path too
+  size_t depth = 0;
+  size_t found = 0;
+  std::set<std::vector<LINK_ID>> paths;
+  std::vector<LINK_ID> links;
+
+  AllPaths(const CsrGraph &_csr, VERTEX_ID _start, VERTEX_ID _end,
+           size_t _max_depth, size_t _max_cases)
+      : csr(_csr), start(_start), end(_end), max_depth(_max_depth),
+        max_cases(_max_cases), visited(_csr.vertices(), false) {
+    visited[start] = (start != end);
+  };
+
+  void explore(VERTEX_ID v) {
+    if (found >= max_cases || ((found > 0 || strict) && depth >= max_depth)) {
+      return;
+    }
+    for (uint32_t i = csr.begin(v); i < csr.end(v) && found < max_cases;
+         ++i) {
+      VERTEX_ID const w = csr.targets[i];
+      if (w == end && (w == start || !visited[w])) {
+        ++found;
+        links.push_back(csr.edge_ids[i]);
+        paths.insert(links);
+        links.pop_back();
+      }
+    }
+    for (uint32_t i = csr.begin(v); i < csr.end(v); ++i) {
+      VERTEX_ID const w = csr.targets[i];
+      if (w == end || visited[w]) {
+        continue;
+      }
+      visited[w] = true;
+      ++depth;
+      links.push_back(csr.edge_ids[i]);
+      explore(w);
+      links.pop_back();
+      --depth;
+      visited[w] = false;
+    }
+  }
+};
+
+} // namespace
+
+TEST(GraphBfsAll, pruned) {
+  std::mt19937 rng(23);
+  for (size_t vertices : {6, 10, 14}) {
+    std::uniform_int_distribution<VERTEX_ID> vertex(0, vertices - 1);
+    Graph g;
+    g.init(vertices);
+    for (size_t e = 0; e < 3 * vertices; ++e) {
+      g.link(vertex(rng), vertex(rng), 0);
+    }
+    g.scan();
+
+    for (VERTEX_ID start = 0; start < 3; ++start) {
+      for (VERTEX_ID end = 0; end < vertices; ++end) {
+        if (!g.reachable(start, end)) {
+          continue;
+        }
+        for (int max_depth : {1, 3, 6, INT_MAX}) {
+          for (int max_cases : {1, 20, INT_MAX}) {
+            AllPaths expected(g.csr(), start, end, max_depth, max_cases);
+            expected.explore(start);
+
+            GraphTravellerBfsAll traveller;
+            traveller.configure({{"START", start},
+                                 {"END", end},
+                                 {"MAX_DEPTH", max_depth},
+                                 {"MAX_CASES", max_cases}});
+            std::string trace;
+            traveller.travel(g, trace);
+            EXPECT_EQ(traveller.found(), expected.found)
+                << start << " to " << end << ", depth " << max_depth
+                << ", cases " << max_cases;
+          }
+        }
+
+        // a seeded walk takes other random numbers than the unpruned search,
+        // the same paths in another order
+        AllPaths expected(g.csr(), start, end, INT_MAX, INT_MAX);
+        expected.explore(start);
+        GraphTravellerBfsAll traveller;
+        traveller.configure({{"START", start},
+                             {"END", end},
+                             {"MAX_CASES", INT_MAX},
+                             {"RANDOM_WALK", 1}});
+        srand(start * vertices + end);
+        MemorySink sink;
+        traveller.travel(g, sink);
+        EXPECT_EQ(traveller.found(), expected.found);
+        std::set<std::vector<LINK_ID>> paths;
+        for (const MemorySink::Case &c : sink.cases()) {
+          paths.insert(c.links);
+        }
+        EXPECT_EQ(paths.size(), sink.cases().size());
+        EXPECT_TRUE(paths == expected.paths);
+      }
+    }
+  }
+}
+
+TEST(GraphBfsAll, parallel) {
+  std::mt19937 rng(29);
+  for (size_t vertices : {8, 12}) {
+    std::uniform_int_distribution<VERTEX_ID> vertex(0, vertices - 1);
+    Graph g;
+    g.init(vertices);
+    for (size_t e = 0; e < 4 * vertices; ++e) {
+      g.link(vertex(rng), vertex(rng), 0);
+    }
+    g.scan();
+
+    for (VERTEX_ID start = 0; start < 2; ++start) {
+      for (VERTEX_ID end = 0; end < vertices; ++end) {
+        if (!g.reachable(start, end)) {
+          continue;
+        }
+        for (int max_depth : {2, 5, INT_MAX}) {
+          AllPaths all(g.csr(), start, end, max_depth, INT_MAX);
+          all.strict = true;
+          all.explore(start);
+
+          for (int max_cases : {1, 50, INT_MAX}) {
+            for (int threads : {1, 3}) {
+              for (int canonical : {0, 1}) {
+                GraphTravellerBfsAll traveller;
+                traveller.configure({{"START", start},
+                                     {"END", end},
+                                     {"MAX_DEPTH", max_depth},
+                                     {"MAX_CASES", max_cases},
+                                     {"PARALLEL", threads},
+                                     {"CANONICAL", canonical}});
+                std::string trace;
+                traveller.travel(g, trace);
+                EXPECT_EQ(traveller.found(),
+                          std::min(all.found, size_t(max_cases)))
+                    << start << " to " << end << ", depth " << max_depth
+                    << ", cases " << max_cases << ", threads " << threads;
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+TEST(GraphBfsAll, sink) {
+  std::mt19937 rng(31);
+  const size_t vertices = 12;
+  std::uniform_int_distribution<VERTEX_ID> vertex(0, vertices - 1);
+  Graph g;
+  g.init(vertices);
+  for (size_t e = 0; e < 4 * vertices; ++e) {
+    g.link(vertex(rng), vertex(rng), 0);
+  }
+  g.scan();
+
+  for (VERTEX_ID end = 0; end < vertices; ++end) {
+    if (!g.reachable(0, end)) {
+      continue;
+    }
+    for (int max_cases : {1, 50, INT_MAX}) {
+      MemorySink one;
+      GraphTravellerBfsAll traveller;
+      traveller.configure(
+          {{"START", 0}, {"END", end}, {"MAX_CASES", max_cases}});
+      traveller.travel(g, one);
+      ASSERT_EQ(one.cases().size(), traveller.found());
+
+      // every case is a path from the start to the end
+      std::set<std::vector<LINK_ID>> paths;
+      for (const MemorySink::Case &c : one.cases()) {
+        EXPECT_EQ(c.start, 0);
+        ASSERT_FALSE(c.links.empty());
+        VERTEX_ID v = c.start;
+        for (LINK_ID l : c.links) {
+          EXPECT_EQ(g.getLink(l)->source.id, v);
+          v = g.getLink(l)->target.id;
+        }
+        EXPECT_EQ(v, end);
+        paths.insert(c.links);
+      }
+      EXPECT_EQ(paths.size(), one.cases().size());
+
+      for (int canonical : {0, 1}) {
+        MemorySink many;
+        traveller.configure({{"START", 0},
+                             {"END", end},
+                             {"MAX_CASES", max_cases},
+                             {"PARALLEL", 3},
+                             {"CANONICAL", canonical}});
+        traveller.travel(g, many);
+        ASSERT_EQ(many.cases().size(), one.cases().size());
+        // canonical: the same cases in the same order
+        for (size_t i = 0; i < many.cases().size(); ++i) {
+          if (canonical == 1) {
+            EXPECT_EQ(many.cases()[i].links, one.cases()[i].links);
+          } else if (max_cases == INT_MAX) {
+            EXPECT_EQ(paths.count(many.cases()[i].links), 1);
+          }
+        }
+      }
+    }
+  }
+}
+
+TEST(GraphBfsAll, batches) {
+  // two chains deeper than the split, then 4^6 paths through the layers, a
+  // task holds more than a batch, MAX_CASES as casegen has it
+  const size_t width = 4, layers = 6, chain = 13;
+  Graph g;
+  g.init(width * layers + 2 * chain + 2);
+  VERTEX_ID const source = width * layers + 2 * chain;
+  VERTEX_ID const target = source + 1;
+  for (size_t c = 0; c < 2; ++c) {
+    VERTEX_ID const first = width * layers + c * chain;
+    g.link(source, first, 0);
+    for (size_t k = 0; k + 1 < chain; ++k) {
+      g.link(first + k, first + k + 1, 0);
+    }
+    for (size_t v = 0; v < width; ++v) {
+      g.link(first + chain - 1, v, 0);
+    }
+  }
+  for (size_t v = 0; v < width; ++v) {
+    g.link((layers - 1) * width + v, target, 0);
+  }
+  for (size_t l = 0; l + 1 < layers; ++l) {
+    for (size_t v = 0; v < width; ++v) {
+      for (size_t w = 0; w < width; ++w) {
+        g.link(l * width + v, (l + 1) * width + w, 0);
+      }
+    }
+  }
+  g.scan();
+  int const max_cases = static_cast<int>(UINT_MAX);
+
+  MemorySink one;
+  GraphTravellerBfsAll traveller;
+  traveller.configure(
+      {{"START", source}, {"END", target}, {"MAX_CASES", max_cases}});
+  traveller.travel(g, one);
+  ASSERT_EQ(one.cases().size(), 2 * 4096);
+  std::set<std::vector<LINK_ID>> paths;
+  for (const MemorySink::Case &c : one.cases()) {
+    paths.insert(c.links);
+  }
+
+  for (int threads : {1, 2, 4}) {
+    for (int canonical : {0, 1}) {
+      MemorySink many;
+      traveller.configure({{"START", source},
+                           {"END", target},
+                           {"MAX_CASES", max_cases},
+                           {"PARALLEL", threads},
+                           {"CANONICAL", canonical}});
+      traveller.travel(g, many);
+      ASSERT_EQ(many.cases().size(), one.cases().size());
+      bool same = true;
+      for (size_t i = 0; i < many.cases().size(); ++i) {
+        same = same && (canonical == 1
+                            ? many.cases()[i].links == one.cases()[i].links
+                            : paths.count(many.cases()[i].links) == 1);
+      }
+      EXPECT_TRUE(same) << threads << " threads, canonical " << canonical;
+    }
+  }
+}
+
+TEST(CaseSink, text) {
+  // more text than the buffer holds, the names as Vertex and Edge make them
+  const size_t vertices = 1000;
+  Graph g;
+  g.init(vertices);
+  for (VERTEX_ID v = 0; v < vertices; ++v) {
+    g.link(v, (v + 1) % vertices, v % 7 - 3);
+  }
+  g.scan();
+
+  std::vector<std::vector<LINK_ID>> cases(200);
+  std::string expected;
+  for (size_t c = 0; c < cases.size(); ++c) {
+    VERTEX_ID const start = c * 13 % vertices;
+    expected += (c > 0 ? "\n" : "") + g.getVertex(start)->name();
+    for (size_t i = 0; i < vertices; ++i) {
+      Link *const l = g.getLink((start + i) % vertices);
+      expected += "--" + l->edge.name() + "-->" + l->target.name();
+      cases[c].push_back(l->edge.id);
+    }
+  }
+  ASSERT_GT(expected.size(), StreamSink::BUFFER_SIZE);
+
+  std::ostringstream out;
+  {
+    StreamSink sink(out);
+    for (const std::vector<LINK_ID> &c : cases) {
+      sink.beginCase(g, g.getLink(c[0])->source.id);
+      for (LINK_ID l : c) {
+        sink.append(l);
+      }
+      sink.endCase();
+    }
+    EXPECT_EQ(sink.cases(), cases.size());
+  }
+  EXPECT_EQ(out.str().size(), expected.size());
+  EXPECT_TRUE(out.str() == expected);
+
+  // by write(2)
+  const std::string file = "case_sink.txt";
+  {
+    FileSink sink(file);
+    for (const std::vector<LINK_ID> &c : cases) {
+      sink.emit(g, g.getLink(c[0])->source.id, c.data(), c.size());
+    }
+    // the last case ended
+    sink.finish();
+  }
+  std::ifstream in(file);
+  std::string const written((std::istreambuf_iterator<char>(in)),
+                            std::istreambuf_iterator<char>());
+  std::remove(file.c_str());
+  EXPECT_EQ(written.size(), expected.size() + 1);
+  EXPECT_TRUE(written == expected + "\n");
+  EXPECT_THROW(FileSink("/nonexistent/case_sink.txt"), std::runtime_error);
+}
+
+TEST(GraphBfsAll, deep) {
+  // one path around a ring, deeper than a recursion could go
+  const size_t vertices = 100000;
+  Graph g;
+  g.init(vertices);
+  for (VERTEX_ID v = 0; v < vertices; ++v) {
+    g.link(v, (v + 1) % vertices, 0);
+    g.link(v, v, 1);
+  }
+  g.setReachPolicy(Graph::RP_SPARSE);
+  g.setScanMethod(Graph::SCAN_SCC);
+  g.scan();
+
+  GraphTravellerBfsAll traveller;
+  traveller.configure(
+      {{"START", 0}, {"END", vertices - 1}, {"MAX_CASES", INT_MAX}});
+  std::string trace;
+  traveller.travel(g, trace);
+  EXPECT_EQ(traveller.found(), 1);
+}
+
+TEST(GraphScan, methods) {
+  std::mt19937 rng(5);
+  for (size_t vertices : {1, 2, 30, 200}) {
+    for (size_t links : {vertices / 2, vertices, 2 * vertices}) {
+      std::uniform_int_distribution<VERTEX_ID> vertex(0, vertices - 1);
+      Graph graphs[5];
+      for (Graph &g : graphs) {
+        g.init(vertices);
+      }
+      for (size_t e = 0; e < links; ++e) {
+        VERTEX_ID const source = vertex(rng);
+        VERTEX_ID const target = vertex(rng);
+        for (Graph &g : graphs) {
+          g.link(source, target, 0);
+        }
+      }
+
+      graphs[0].setScanMethod(Graph::SCAN_BFS);
+      graphs[1].setScanMethod(Graph::SCAN_CLOSURE);
+      graphs[3].setReachPolicy(Graph::RP_SPARSE);
+      graphs[4].setScanMethod(Graph::SCAN_MSBFS);
+      for (Graph &g : graphs) {
+        g.scan();
+      }
+
+      for (VERTEX_ID i = 0; i < vertices; ++i) {
+        for (VERTEX_ID j = 0; j < vertices; ++j) {
+          bool const expected = graphs[0].reachable(i, j);
+          ASSERT_EQ(graphs[1].reachable(i, j), expected);
+          ASSERT_EQ(graphs[2].reachable(i, j), expected);
+          ASSERT_EQ(graphs[3].reachable(i, j), expected);
+          ASSERT_EQ(graphs[4].reachable(i, j), expected);
+          // same component iff reachable both ways
+          if (i != j) {
+            ASSERT_EQ(graphs[2].sccId(i) == graphs[2].sccId(j),
+                      expected && graphs[0].reachable(j, i));
+          }
+        }
+      }
+    }
+  }
+}
+
+TEST(GraphScan, threads) {
+  // enough vertices and components for several chunks per worker
+  const size_t vertices = 1500;
+  std::mt19937 rng(9);
+  std::uniform_int_distribution<VERTEX_ID> vertex(0, vertices - 1);
+  Graph graphs[2];
+  for (Graph &g : graphs) {
+    g.init(vertices);
+  }
+  for (size_t e = 0; e < vertices; ++e) {
+    VERTEX_ID const source = vertex(rng);
+    VERTEX_ID const target = vertex(rng);
+    for (Graph &g : graphs) {
+      g.link(source, target, 0);
+    }
+  }
+
+  for (auto method :
+       {Graph::SCAN_BFS, Graph::SCAN_SCC, Graph::SCAN_MSBFS}) {
+    for (auto policy : {Graph::RP_DENSE, Graph::RP_SPARSE}) {
+      graphs[0].setScanThreads(1);
+      graphs[1].setScanThreads(4);
+      for (Graph &g : graphs) {
+        g.setScanMethod(method);
+        g.setReachPolicy(policy);
+        g.scan();
+      }
+      for (VERTEX_ID i = 0; i < vertices; ++i) {
+        for (VERTEX_ID j = 0; j < vertices; ++j) {
+          ASSERT_EQ(graphs[0].reachable(i, j), graphs[1].reachable(i, j));
+        }
+      }
+    }
+  }
+}
+
 /*
 TEST_F(GraphTest, SearchAll) {
   IGraphTraveller * pTraveller =
@@ -71,34 +821,28 @@ IGraphTraveller::createInstance(IGraphTraveller::GT_BFS_ALL); Properties config;
 TEST_F(GraphTest, SearchDfs) {
   // g.dump();
   auto pTraveller = IGraphTraveller::createInstance(IGraphTraveller::GT_DFS);
-  string trace;
+  std::string trace;
   pTraveller->travel(graph(), trace);
-  cout << trace << '\n';
+  std::cout << trace << '\n';
 }
 
 TEST_F(GraphTest, SearchDfsPath) {
   // g.dump();
   auto pTraveller =
       IGraphTraveller::createInstance(IGraphTraveller::GT_DFS_PATH);
-  string trace;
+  std::string trace;
   pTraveller->travel(graph(), trace);
-  cout << trace << '\n';
+  std::cout << trace << '\n';
 }
 
 TEST_F(GraphTest, Shortest) {
-  LinkList *path = nullptr;
+  GraphTravellerBfsOne traveller;
   for (VERTEX_ID i = 0; i < graph().size(); ++i)
     for (VERTEX_ID j = 11; j < graph().size(); ++j) {
-      path = GraphTravellerBfs::shortestPath(&graph, graph().getVertex(i),
-                                             graph().getVertex(j));
-      if (graph().reachable(i, j)) {
-        EXPECT_FALSE(nullptr == path);
-      } else {
-        EXPECT_TRUE(nullptr == path);
-      }
-      if (path) {
-        delete path;
-      }
+      traveller.configure({{"START", i}, {"END", j}});
+      MemorySink path;
+      traveller.travel(graph(), path);
+      EXPECT_EQ(path.cases().size(), graph().reachable(i, j) ? 1 : 0);
     }
 }
 
@@ -106,24 +850,49 @@ TEST_F(GraphTest, SearchOne) {
   auto pTraveller =
       IGraphTraveller::createInstance(IGraphTraveller::GT_BFS_ONE);
   Properties config;
-  for (size_t start = 0; start < graph.size(); ++start) {
-    for (size_t end = 0; end < graph.size(); ++end) {
+  for (size_t start = 0; start < graph().size(); ++start) {
+    for (size_t end = 0; end < graph().size(); ++end) {
       config["START"] = start;
       config["END"] = end;
       pTraveller->configure(config);
-      string trace;
-      pTraveller->travel(graph, trace);
-      cout << trace << '\n';
+      std::string trace;
+      pTraveller->travel(graph(), trace);
+      std::cout << trace << '\n';
     }
   }
 }
 
-TEST_F(GraphTest, eulerization) { graph.eulerize(); }
+TEST_F(GraphTest, eulerization) {
+  size_t const links = graph().getLinks().size();
+  graph().eulerize();
+  EXPECT_TRUE(graph().eulerian());
+  // no link added, some are walked several times
+  EXPECT_EQ(graph().getLinks().size(), links);
+  EXPECT_TRUE(graph().frozen());
+  size_t walks = 0;
+  for (LINK_ID e = 0; e < links; ++e) {
+    EXPECT_GE(graph().multiplicity(e), 1);
+    walks += graph().multiplicity(e);
+  }
+  EXPECT_GT(walks, links);
+}
 
 TEST_F(GraphTest, eulerwalk) {
-  graph.eulerize();
+  graph().eulerize();
   auto pTraveller = IGraphTraveller::createInstance(IGraphTraveller::GT_EULER);
-  string trace;
-  pTraveller->travel(graph, trace);
-  cout << trace << '\n';
+  std::string trace;
+  pTraveller->travel(graph(), trace);
+  std::cout << trace << '\n';
+
+  // every link is walked as many times as its multiplicity
+  size_t walks = 0;
+  for (uint32_t const m : graph().multiplicities()) {
+    walks += m;
+  }
+  size_t steps = 0;
+  for (size_t pos = trace.find("-->"); pos != std::string::npos;
+       pos = trace.find("-->", pos + 1)) {
+    ++steps;
+  }
+  EXPECT_EQ(steps, walks);
 }
@@ -0,0 +1,100 @@
+#include <algorithm>
+#include <cstdint>
+#include <queue>
+#include <random>
+#include <vector>
+
+#include <graph.h>
+#include <gtest/gtest.h>
+#include <msbfs.h>
+
+namespace {
+// distances from s by a plain BFS
+std::vector<uint32_t> bfs(const Graph &g, const VERTEX_ID s) {
+  std::vector<uint32_t> d(g.size(), MultiSourceBfs::UNREACHABLE);
+  std::queue<VERTEX_ID> q;
+  d[s] = 0;
+  q.push(s);
+  while (!q.empty()) {
+    VERTEX_ID const v = q.front();
+    q.pop();
+    for (Link *l : g.getAdjacencies(v)) {
+      if (d[l->target.id] == MultiSourceBfs::UNREACHABLE) {
+        d[l->target.id] = d[v] + 1;
+        q.push(l->target.id);
+      }
+    }
+  }
+  return d;
+}
+} // namespace
+
+TEST(MultiSourceBfs, distances) {
+  const size_t vertices = 150;
+  std::mt19937 rng(13);
+  std::uniform_int_distribution<VERTEX_ID> vertex(0, vertices - 1);
+  Graph g;
+  g.init(vertices);
+  for (size_t e = 0; e < 2 * vertices; ++e) {
+    g.link(vertex(rng), vertex(rng), 0);
+  }
+  g.freeze();
+
+  // more than one batch, with a duplicated source
+  std::vector<VERTEX_ID> sources;
+  for (VERTEX_ID v = 0; v < vertices; ++v) {
+    sources.push_back(v);
+  }
+  sources.push_back(7);
+
+  MultiSourceBfs msbfs(g);
+  std::vector<std::vector<uint32_t>> distances;
+  msbfs.distances(sources, distances);
+  ASSERT_EQ(distances.size(), sources.size());
+  std::vector<uint32_t> eccentricity = msbfs.eccentricity(sources);
+  ASSERT_EQ(eccentricity.size(), sources.size());
+
+  for (size_t i = 0; i < sources.size(); ++i) {
+    std::vector<uint32_t> const expected = bfs(g, sources[i]);
+    EXPECT_EQ(distances[i], expected) << "source " << sources[i];
+
+    uint32_t farthest = 0;
+    for (uint32_t d : expected) {
+      if (d != MultiSourceBfs::UNREACHABLE) {
+        farthest = std::max(farthest, d);
+      }
+    }
+    EXPECT_EQ(eccentricity[i], farthest) << "source " << sources[i];
+  }
+}
+
+TEST(MultiSourceBfs, reachable) {
+  // 0 -> 1 -> 2 -> 1, 3 alone
+  Graph g;
+  g.init(4);
+  g.link(0, 1, 0);
+  g.link(1, 2, 0);
+  g.link(2, 1, 0);
+  g.freeze();
+
+  MultiSourceBfs msbfs(g);
+  VERTEX_ID const sources[] = {0, 1, 3};
+  std::vector<std::vector<bool>> seen(3, std::vector<bool>(4, false));
+  msbfs.run(
+      sources, 3,
+      [&seen](VERTEX_ID v, MultiSourceBfs::LANES lanes, size_t depth) {
+        EXPECT_GT(depth, 0);
+        for (size_t i = 0; i < 3; ++i) {
+          if (lanes & (static_cast<MultiSourceBfs::LANES>(1) << i)) {
+            EXPECT_FALSE(seen[i][v]);
+            seen[i][v] = true;
+          }
+        }
+      },
+      false);
+
+  // a source is only reached again through a cycle
+  EXPECT_EQ(seen[0], std::vector<bool>({false, true, true, false}));
+  EXPECT_EQ(seen[1], std::vector<bool>({false, true, true, false}));
+  EXPECT_EQ(seen[2], std::vector<bool>({false, false, false, false}));
+}
@@ -0,0 +1,175 @@
+#include <cstddef>
+#include <random>
+#include <stdexcept>
+
+#include <bitmap.h>
+#include <gtest/gtest.h>
+#include <roaring_bitmap.h>
+
+namespace {
+// random bits on both maps, clustered in a few ranges so the chunks go
+// through all the container types
+void fill(BitMap &dense, RoaringBitMap &sparse, std::mt19937 &rng) {
+  std::uniform_int_distribution<size_t> pos(0, dense.size() - 1);
+  for (size_t i = 0; i < 3000; ++i) {
+    size_t p = pos(rng);
+    dense.set(p);
+    sparse.set(p);
+  }
+  // a dense chunk, above the array limit
+  for (size_t p = 70000; p < 70000 + 9000 && p < dense.size(); ++p) {
+    dense.set(p);
+    sparse.set(p);
+  }
+}
+
+void expect_same(const BitMap &dense, const RoaringBitMap &sparse) {
+  ASSERT_EQ(dense.size(), sparse.size());
+  EXPECT_EQ(dense.count(), sparse.count());
+  for (size_t i = 0; i < dense.size(); ++i) {
+    ASSERT_EQ(dense.get(i), sparse.get(i)) << "bit " << i;
+  }
+}
+} // namespace
+
+TEST(RoaringBitMap, set_get) {
+  RoaringBitMap bitmap(200000);
+  EXPECT_EQ(bitmap.size(), 200000);
+  EXPECT_TRUE(bitmap.all0());
+
+  bitmap.set(0);
+  bitmap.set(65535);
+  bitmap.set(65536);
+  bitmap.set(199999);
+  bitmap.set(200000); // out of range, ignored
+  EXPECT_EQ(bitmap.count(), 4);
+  EXPECT_TRUE(bitmap[0]);
+  EXPECT_TRUE(bitmap[65535]);
+  EXPECT_TRUE(bitmap[65536]);
+  EXPECT_TRUE(bitmap[199999]);
+  EXPECT_FALSE(bitmap[1]);
+  EXPECT_FALSE(bitmap[200000]);
+
+  bitmap.reset(65535);
+  EXPECT_FALSE(bitmap[65535]);
+  EXPECT_EQ(bitmap.count(), 3);
+
+  bitmap.set();
+  EXPECT_TRUE(bitmap.all1());
+  EXPECT_EQ(bitmap.count(), 200000);
+  bitmap.reset(100);
+  EXPECT_FALSE(bitmap.all1());
+  EXPECT_FALSE(bitmap[100]);
+  EXPECT_TRUE(bitmap[101]);
+
+  bitmap.reset();
+  EXPECT_TRUE(bitmap.all0());
+}
+
+TEST(RoaringBitMap, containers) {
+  std::mt19937 rng(7);
+  BitMap dense(300000);
+  RoaringBitMap sparse(300000);
+  fill(dense, sparse, rng);
+  expect_same(dense, sparse);
+
+  // remove part of the dense chunk, the container goes back to array
+  for (size_t p = 70000; p < 76000; ++p) {
+    dense.reset(p);
+    sparse.reset(p);
+  }
+  expect_same(dense, sparse);
+
+  RoaringBitMap copy(sparse);
+  sparse.optimize();
+  EXPECT_TRUE(copy == sparse);
+  expect_same(dense, sparse);
+
+  // mutate after compression
+  sparse.set(123);
+  sparse.reset(76001);
+  dense.set(123);
+  dense.reset(76001);
+  expect_same(dense, sparse);
+
+  RoaringBitMap loaded(300000);
+  loaded.assign(dense);
+  expect_same(dense, loaded);
+  EXPECT_TRUE(loaded == sparse);
+
+  // runs are smaller than the array and bitset of the same bits
+  RoaringBitMap ranges(300000);
+  BitMap all(300000);
+  all.set();
+  ranges.assign(all);
+  EXPECT_TRUE(ranges.all1());
+  EXPECT_LT(ranges.memory(), 1024);
+
+  EXPECT_THROW(loaded.assign(BitMap(100)), std::out_of_range);
+}
+
+TEST(RoaringBitMap, manipulate) {
+  std::mt19937 rng(11);
+  BitMap d1(150000), d2(150000);
+  RoaringBitMap s1(150000), s2(150000);
+  fill(d1, s1, rng);
+  fill(d2, s2, rng);
+
+  expect_same(d1 & d2, s1 & s2);
+  expect_same(d1 | d2, s1 | s2);
+
+  EXPECT_TRUE((s1 | s2) >= s1);
+  EXPECT_TRUE(s1 <= (s1 | s2));
+  EXPECT_TRUE((s1 & s2) <= s2);
+  EXPECT_FALSE(s1 >= s2);
+  EXPECT_TRUE(s1 != s2);
+  EXPECT_TRUE((s1 | s2) > s1);
+
+  s2.optimize();
+  expect_same(d1 | d2, s1 | s2);
+  expect_same(d1 & d2, s1 & s2);
+
+  // the bits beyond the size are dropped
+  RoaringBitMap small(70005);
+  small |= s1;
+  size_t n = 0;
+  for (size_t i = 0; i < 70005; ++i) {
+    ASSERT_EQ(small.get(i), s1.get(i));
+    n += s1.get(i);
+  }
+  EXPECT_EQ(small.count(), n);
+}
+
+TEST(RoaringBitMap2, set_get) {
+  RoaringBitMap2 bitmap(100, 70000);
+  EXPECT_EQ(bitmap.rows(), 100);
+  EXPECT_EQ(bitmap.cols(), 70000);
+  EXPECT_EQ(bitmap.size(), 7000000);
+  EXPECT_TRUE(bitmap.all0());
+
+  bitmap.set(3, 69999);
+  bitmap.set(99, 0);
+  bitmap.set(100, 0); // out of range, ignored
+  EXPECT_TRUE(bitmap.get(3, 69999));
+  EXPECT_TRUE(bitmap[99][0]);
+  EXPECT_FALSE(bitmap.get(3, 0));
+  EXPECT_EQ(bitmap[3].count(), 1);
+
+  RoaringBitMap2 other(100, 70000);
+  other.set(3, 69999);
+  EXPECT_TRUE(bitmap >= other);
+  EXPECT_TRUE(other <= bitmap);
+  other |= bitmap;
+  EXPECT_TRUE(other == bitmap);
+  other.reset(99, 0);
+  EXPECT_TRUE(other != bitmap);
+
+  bitmap.set();
+  EXPECT_TRUE(bitmap.all1());
+  bitmap.optimize();
+  EXPECT_TRUE(bitmap.all1());
+  EXPECT_LT(bitmap.memory(), BitMap2(100, 70000).memory());
+
+  EXPECT_THROW(bitmap[100], std::out_of_range);
+  EXPECT_THROW(bitmap &= RoaringBitMap2(10, 10), std::out_of_range);
+}
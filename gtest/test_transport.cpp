@@ -0,0 +1,118 @@
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include <graph.h>
+#include <gtest/gtest.h>
+#include <transport.h>
+
+namespace {
+typedef std::vector<std::vector<uint32_t>> Matrix;
+
+// every flow matrix, the best (largest total, then lowest cost) one
+void brute(const std::vector<uint32_t> &supply, std::vector<uint32_t> &demand,
+           const Matrix &cost, size_t cell, uint64_t total, uint64_t sum,
+           std::pair<uint64_t, uint64_t> &best, std::vector<uint32_t> &left) {
+  size_t const n = demand.size();
+  if (cell == supply.size() * n) {
+    if (total > best.first || (total == best.first && sum < best.second)) {
+      best = {total, sum};
+    }
+    return;
+  }
+  size_t const i = cell / n;
+  size_t const j = cell % n;
+  uint32_t const most = cost[i][j] == Transportation::NO_ROUTE
+                            ? 0
+                            : std::min(left[i], demand[j]);
+  for (uint32_t units = 0; units <= most; ++units) {
+    left[i] -= units;
+    demand[j] -= units;
+    brute(supply, demand, cost, cell + 1, total + units,
+          sum + units * cost[i][j], best, left);
+    left[i] += units;
+    demand[j] += units;
+  }
+}
+} // namespace
+
+TEST(Transportation, optimal) {
+  std::mt19937 rng(16);
+  std::uniform_int_distribution<uint32_t> units(0, 3);
+  std::uniform_int_distribution<uint32_t> price(0, 9);
+  for (size_t round = 0; round < 200; ++round) {
+    size_t const m = 1 + round % 3;
+    size_t const n = 1 + round / 3 % 3;
+    std::vector<uint32_t> supply(m), demand(n);
+    for (uint32_t &s : supply) {
+      s = units(rng);
+    }
+    for (uint32_t &d : demand) {
+      d = units(rng);
+    }
+    Matrix cost(m, std::vector<uint32_t>(n));
+    for (auto &row : cost) {
+      for (uint32_t &c : row) {
+        c = price(rng);
+        if (c == 9) {
+          c = Transportation::NO_ROUTE;
+        }
+      }
+    }
+
+    Transportation t(supply, demand, cost);
+    t.solve();
+    std::pair<uint64_t, uint64_t> best(0, 0);
+    std::vector<uint32_t> left = supply;
+    brute(supply, demand, cost, 0, 0, 0, best, left);
+    ASSERT_EQ(t.total(), best.first) << "round " << round;
+    ASSERT_EQ(t.totalCost(), best.second) << "round " << round;
+
+    // the flow respects the supplies, the demands and the routes
+    uint64_t total = 0;
+    for (size_t i = 0; i < m; ++i) {
+      uint64_t sent = 0;
+      for (size_t j = 0; j < n; ++j) {
+        sent += t.flow()[i][j];
+        if (cost[i][j] == Transportation::NO_ROUTE) {
+          ASSERT_EQ(t.flow()[i][j], 0);
+        }
+      }
+      ASSERT_LE(sent, supply[i]);
+      total += sent;
+    }
+    ASSERT_EQ(total, t.total());
+  }
+}
+
+TEST(Transportation, eulerize) {
+  // 0 -> 1 -> 2 -> 0 and 0 -> 2, the cheapest fix walks 2 -> 0 twice
+  Graph g;
+  g.init(3);
+  g.link(0, 1, 0);
+  g.link(1, 2, 0);
+  g.link(2, 0, 0);
+  g.link(0, 2, 1);
+  g.scan();
+  g.eulerize();
+  EXPECT_TRUE(g.eulerian());
+  EXPECT_EQ(g.multiplicities(), std::vector<uint32_t>({1, 1, 2, 1}));
+
+  // a strongly connected random graph always gets balanced
+  std::mt19937 rng(6);
+  const size_t vertices = 300;
+  std::uniform_int_distribution<VERTEX_ID> vertex(0, vertices - 1);
+  Graph r;
+  r.init(vertices);
+  for (VERTEX_ID v = 0; v < vertices; ++v) {
+    r.link(v, (v + 1) % vertices, 0);
+  }
+  for (size_t e = 0; e < 2 * vertices; ++e) {
+    r.link(vertex(rng), vertex(rng), 1);
+  }
+  r.scan();
+  r.eulerize();
+  EXPECT_TRUE(r.eulerian());
+}
@@ -0,0 +1,52 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+#include "arena.h"
+
+using namespace std;
+
+void *Arena::allocate(size_t bytes, size_t align) {
+  uintptr_t aligned =
+      (reinterpret_cast<uintptr_t>(m_cursor) + align - 1) & ~(align - 1);
+  if (m_cursor == nullptr ||
+      aligned + bytes > reinterpret_cast<uintptr_t>(m_end)) {
+    // a new block, big enough for an object larger than the block size
+    size_t const header = max(sizeof(Block), align);
+    size_t const size = max(m_block_size, header + bytes);
+    Block *const block = static_cast<Block *>(malloc(size));
+    if (block == nullptr) {
+      throw bad_alloc();
+    }
+    block->next = m_head;
+    m_head = block;
+    m_memory += size;
+    ++m_blocks;
+
+    m_cursor = reinterpret_cast<char *>(block) + sizeof(Block);
+    m_end = reinterpret_cast<char *>(block) + size;
+    aligned =
+        (reinterpret_cast<uintptr_t>(m_cursor) + align - 1) & ~(align - 1);
+  }
+
+  m_cursor = reinterpret_cast<char *>(aligned + bytes);
+  return reinterpret_cast<void *>(aligned);
+}
+
+void Arena::reset() {
+  // the newest objects first, they may refer to the older ones
+  for (Destructor *d = m_destructors; d != nullptr; d = d->next) {
+    d->destroy(d->object);
+  }
+  m_destructors = nullptr;
+
+  while (m_head != nullptr) {
+    Block *const next = m_head->next;
+    free(m_head);
+    m_head = next;
+  }
+  m_cursor = m_end = nullptr;
+  m_memory = 0;
+  m_blocks = 0;
+}
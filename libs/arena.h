@@ -0,0 +1,76 @@
+#ifndef CASEGEN_ARENA_H_
+#define CASEGEN_ARENA_H_
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// monotonic arena, the objects are carved out of big blocks and never freed
+// one by one, reset() (or the destructor) runs the destructors of all the
+// objects in reverse order of creation and releases the blocks in one step
+// the record of a destructor is allocated in the arena too, only the types
+// with a non trivial destructor need one
+// not thread safe
+class Arena {
+public:
+  static constexpr size_t DEFAULT_BLOCK = 64 * 1024;
+
+  explicit Arena(size_t block_size = DEFAULT_BLOCK)
+      : m_block_size(block_size){};
+  Arena(const Arena &rhs) = delete;
+  Arena &operator=(const Arena &rhs) = delete;
+
+  virtual ~Arena() { reset(); };
+
+  // raw memory, align must be a power of 2
+  void *allocate(size_t bytes, size_t align = alignof(std::max_align_t));
+
+  // construct a T in the arena, it lives until the next reset
+  template <typename T, typename... ARGS> T *create(ARGS &&...args);
+
+  // destroy all the objects and release all the blocks
+  void reset();
+
+  // bytes of the blocks held by the arena
+  size_t memory() const { return m_memory; };
+  // number of blocks held by the arena
+  size_t blocks() const { return m_blocks; };
+
+private:
+  struct Block {
+    Block *next;
+  };
+  struct Destructor {
+    Destructor *next;
+    void (*destroy)(void *);
+    void *object;
+  };
+
+  template <typename T> static void destroy(void *object) {
+    static_cast<T *>(object)->~T();
+  };
+
+  size_t m_block_size;
+  Block *m_head{nullptr};
+  char *m_cursor{nullptr};
+  char *m_end{nullptr};
+  Destructor *m_destructors{nullptr};
+  size_t m_memory{0};
+  size_t m_blocks{0};
+};
+
+template <typename T, typename... ARGS> T *Arena::create(ARGS &&...args) {
+  void *const memory = allocate(sizeof(T), alignof(T));
+  T *const object = new (memory) T(std::forward<ARGS>(args)...);
+  if (!std::is_trivially_destructible<T>::value) {
+    // recorded once the object is constructed, a throwing constructor leaves
+    // nothing to destroy
+    void *const record = allocate(sizeof(Destructor), alignof(Destructor));
+    m_destructors =
+        new (record) Destructor{m_destructors, &Arena::destroy<T>, object};
+  }
+  return object;
+}
+
+#endif
@@ -0,0 +1,111 @@
+#ifndef CASEGEN_ATOMIC_BITMAP_H_
+#define CASEGEN_ATOMIC_BITMAP_H_
+
+#include <atomic>
+#include <cstddef>
+
+#include "bitmap.h"
+
+// bit map shared by several threads without lock
+// every bit is changed by an atomic fetch_or/fetch_and on its block, so the
+// threads of a parallel traversal can mark the visited vertices or edges on
+// the same map, test_and_set tells which thread visited first
+// the memory order of each operation can be given, the defaults make a bit
+// set by a thread (release) visible with the data written before it to the
+// thread reading it (acquire)
+// the bulk functions (reset, count, snapshot) are not atomic as a whole
+class AtomicBitMap {
+public:
+  explicit AtomicBitMap(size_t size)
+      : m_size(size), m_table_len(BitMap::blocks(size)),
+        m_bits(new std::atomic<MARKER_BLOCK>[m_table_len]) {
+    reset();
+  };
+  AtomicBitMap(const AtomicBitMap &rhs) = delete;
+  AtomicBitMap &operator=(const AtomicBitMap &rhs) = delete;
+  AtomicBitMap() = delete;
+
+  virtual ~AtomicBitMap() { delete[] m_bits; };
+
+  // the capacity of bit map
+  size_t size() const { return m_size; };
+
+  // set the bit to 1 at pos, return the value before
+  bool test_and_set(const size_t pos,
+                    std::memory_order order = std::memory_order_acq_rel) {
+    if (pos < m_size) {
+      MARKER_BLOCK const mask = BitMap::mask(pos);
+      return ((m_bits[BitMap::offset(pos)].fetch_or(mask, order) & mask) != 0);
+    }
+    return false;
+  };
+  // set the bit to 0 at pos, return the value before
+  bool test_and_reset(const size_t pos,
+                      std::memory_order order = std::memory_order_acq_rel) {
+    if (pos < m_size) {
+      MARKER_BLOCK const mask = BitMap::mask(pos);
+      return ((m_bits[BitMap::offset(pos)].fetch_and(~mask, order) & mask) !=
+              0);
+    }
+    return false;
+  };
+
+  void set(const size_t pos,
+           std::memory_order order = std::memory_order_release) {
+    test_and_set(pos, order);
+  };
+  void reset(const size_t pos,
+             std::memory_order order = std::memory_order_release) {
+    test_and_reset(pos, order);
+  };
+
+  // get the val at pos
+  bool get(const size_t pos,
+           std::memory_order order = std::memory_order_acquire) const {
+    if (pos < m_size) {
+      return ((m_bits[BitMap::offset(pos)].load(order) & BitMap::mask(pos)) !=
+              0);
+    }
+    return false;
+  };
+  bool operator[](const size_t pos) const { return get(pos); };
+
+  // set all bits to 0, not to be called while other threads use the map
+  void reset() {
+    for (size_t i = 0; i < m_table_len; ++i) {
+      m_bits[i].store(0, std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+  };
+
+  // number of bits set to 1
+  size_t count(std::memory_order order = std::memory_order_acquire) const {
+    size_t n = 0;
+    for (size_t i = 0; i < m_table_len; ++i) {
+      n += __builtin_popcountll(m_bits[i].load(order));
+    }
+    return n;
+  };
+
+  // copy the bits to a plain bit map, block by block
+  BitMap snapshot(std::memory_order order = std::memory_order_acquire) const {
+    BitMap value(m_size);
+    snapshot(value, order);
+    return value;
+  };
+  void snapshot(BitMap &value,
+                std::memory_order order = std::memory_order_acquire) const {
+    value.assign(m_size);
+    MARKER_BLOCK *const bits = value.view().data();
+    for (size_t i = 0; i < m_table_len; ++i) {
+      bits[i] = m_bits[i].load(order);
+    }
+  };
+
+private:
+  size_t m_size;
+  size_t m_table_len;
+  std::atomic<MARKER_BLOCK> *m_bits;
+};
+
+#endif
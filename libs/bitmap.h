@@ -1,17 +1,42 @@
 #ifndef CASEGEN_BITMAP_H_
 #define CASEGEN_BITMAP_H_
 
-const int MARKER_BLOCK_BITS = 8;
-
+#include <algorithm>
+#include <cstdint>
 #include <cstring>
 #include <iostream>
+#include <iterator>
 #include <stdexcept>
+#include <utility>
 #include <vector>
 
+#include "bitmap_kernel.h"
+
+// bits are stored in 64-bit blocks, so bulk operations work a machine word at
+// a time and counting/scanning use the popcount and ctz builtins
+const int MARKER_BLOCK_BITS = 64;
+
+template <typename BLOCK> class BitMapSpan;
+// read-only view on the bits of a BitMap or of a BitMap2 row
+typedef BitMapSpan<const MARKER_BLOCK> BitMapView;
+// writable view on the bits of a BitMap or of a BitMap2 row
+typedef BitMapSpan<MARKER_BLOCK> MutableBitMapView;
+
 class BitMap {
 public:
   static size_t offset(const size_t n) { return (n / MARKER_BLOCK_BITS); };
   static unsigned char bits(const size_t n) { return (n % MARKER_BLOCK_BITS); };
+  static MARKER_BLOCK mask(const size_t n) {
+    return (static_cast<MARKER_BLOCK>(1) << bits(n));
+  };
+  // number of blocks needed to hold n bits
+  static size_t blocks(const size_t n) {
+    return ((n + MARKER_BLOCK_BITS - 1) / MARKER_BLOCK_BITS);
+  };
+  // the valid bits of the last block of a n bits bit map
+  static MARKER_BLOCK tail_mask(const size_t n) {
+    return (bits(n) == 0) ? ~static_cast<MARKER_BLOCK>(0) : mask(n) - 1;
+  };
 
   static void mem_dump(void *mem, const size_t len) {
     unsigned char *pp = static_cast<unsigned char *>(mem);
@@ -21,41 +46,77 @@ public:
     std::cout << "\n";
   };
 
+  // bit maps up to INLINE_BLOCKS blocks are stored in the object itself, the
+  // bigger ones on the heap, so the views on a small bit map do not survive
+  // a move of it
+  static constexpr size_t INLINE_BLOCKS = 8;
+
   // constructors
-  explicit BitMap(size_t size);
-  BitMap(const BitMap &rhs);
-  BitMap(BitMap &&rhs) noexcept;
-  BitMap &operator=(BitMap &&rhs) noexcept;
+  explicit BitMap(size_t size)
+      : m_size(size), m_table_len(blocks(size)),
+        m_bits(allocate(m_table_len)) {
+    memset(m_bits, 0, m_table_len * sizeof(MARKER_BLOCK));
+  };
+  BitMap(const BitMap &rhs)
+      : m_size(rhs.m_size), m_table_len(rhs.m_table_len),
+        m_bits(allocate(m_table_len)) {
+    memcpy(m_bits, rhs.m_bits, m_table_len * sizeof(MARKER_BLOCK));
+  };
+  BitMap(BitMap &&rhs) noexcept
+      : m_size(0), m_table_len(0), m_bits(m_inline) {
+    steal(rhs);
+  };
+  BitMap &operator=(BitMap &&rhs) noexcept {
+    if (this != &rhs) {
+      release();
+      steal(rhs);
+    }
+    return *this;
+  };
   BitMap() = delete;
 
   // destructor
-  virtual ~BitMap();
+  virtual ~BitMap() { release(); };
+
+  // resize to size bits all set to 0, the storage is reused when the number
+  // of blocks does not change
+  void assign(const size_t size) {
+    if (blocks(size) != m_table_len) {
+      release();
+      m_table_len = blocks(size);
+      m_bits = allocate(m_table_len);
+    }
+    m_size = size;
+    reset();
+  };
 
   // set all bits to 1
-  virtual void set() { memset(m_bits, 0xff, m_table_len); }
+  virtual void set() {
+    memset(m_bits, 0xff, m_table_len * sizeof(MARKER_BLOCK));
+    trim();
+  }
 
   // set the bit to 1 at pos
   virtual void set(const size_t pos) {
     if (pos < m_size) {
-      m_bits[offset(pos)] |= (1 << bits(pos));
+      m_bits[offset(pos)] |= mask(pos);
     }
   };
 
   // set all bits to 0
-  void reset() { memset(m_bits, 0, m_table_len); };
+  void reset() { memset(m_bits, 0, m_table_len * sizeof(MARKER_BLOCK)); };
 
   // set the bit to 0 at pos
   void reset(const size_t pos) {
     if (pos < m_size) {
-      m_bits[offset(pos)] &= ~(1 << bits(pos));
+      m_bits[offset(pos)] &= ~mask(pos);
     }
   };
 
   // get the val at pos
   virtual bool get(const size_t pos) const {
     if (pos < m_size) {
-      unsigned char const mask = 1 << bits(pos);
-      return (mask == (m_bits[offset(pos)] & mask));
+      return ((m_bits[offset(pos)] & mask(pos)) != 0);
     }
 
     return false;
@@ -66,53 +127,106 @@ public:
   // the capacity of bit map
   virtual size_t size() const { return m_size; };
 
-  // all the bits are 0
-  virtual bool all0() const {
-    unsigned char cc = 0;
-    for (size_t i = 0; i < offset(m_size); ++i) {
-      if (m_bits[i] ^ 0) {
-        return false;
-      }
-    }
+  // number of bits set to 1
+  size_t count() const {
+    return BitMapKernel::active().count(m_bits, m_table_len);
+  };
 
-    // if has remains
-    if (bits(m_size) != 0) {
-      for (size_t i = bits(m_size); i > 0; --i) {
-        cc = (m_bits[m_table_len - 1] >> (i - 1)) & 1;
-        if (cc ^ 0) {
-          return false;
-        }
-      }
-    }
+  // position of no bit, returned by the find functions
+  static constexpr size_t npos = static_cast<size_t>(-1);
 
-    return true;
+  // the position of the first bit set to 1, npos if all the bits are 0
+  size_t find_first() const { return find_from<true>(0); };
+  // the position of the first bit set to 1 after pos, npos if none
+  size_t find_next(const size_t pos) const {
+    return (pos == npos) ? npos : find_from<true>(pos + 1);
+  };
+  // the position of the first bit set to 0, npos if all the bits are 1
+  size_t find_first_unset() const { return find_from<false>(0); };
+  // the position of the first bit set to 0 after pos, npos if none
+  size_t find_next_unset(const size_t pos) const {
+    return (pos == npos) ? npos : find_from<false>(pos + 1);
+  };
+
+  // forward iterator on the positions of the bits equal to VALUE
+  // the bit map can be changed while iterating, the iterator always moves to
+  // the next matching bit of the current content
+  template <bool VALUE> class BitIterator {
+  public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef size_t value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const size_t *pointer;
+    typedef size_t reference;
+
+    BitIterator(const BitMap &bitmap, const size_t pos)
+        : m_bitmap(&bitmap), m_pos(pos){};
+
+    size_t operator*() const { return m_pos; };
+    BitIterator &operator++() {
+      m_pos = (m_pos == npos) ? npos : m_bitmap->find_from<VALUE>(m_pos + 1);
+      return *this;
+    };
+    BitIterator operator++(int) {
+      BitIterator it = *this;
+      ++(*this);
+      return it;
+    };
+    bool operator==(const BitIterator &rhs) const {
+      return (m_pos == rhs.m_pos && m_bitmap == rhs.m_bitmap);
+    };
+    bool operator!=(const BitIterator &rhs) const { return !(*this == rhs); };
+
+  private:
+    const BitMap *m_bitmap;
+    size_t m_pos;
+  };
+
+  // range of the positions of the bits equal to VALUE, for range based loops
+  template <bool VALUE> class BitRange {
+  public:
+    explicit BitRange(const BitMap &bitmap) : m_bitmap(bitmap){};
+    BitIterator<VALUE> begin() const {
+      return BitIterator<VALUE>(m_bitmap, m_bitmap.find_from<VALUE>(0));
+    };
+    BitIterator<VALUE> end() const {
+      return BitIterator<VALUE>(m_bitmap, npos);
+    };
+
+  private:
+    const BitMap &m_bitmap;
+  };
+
+  // positions of the bits set to 1
+  BitRange<true> set_bits() const { return BitRange<true>(*this); };
+  // positions of the bits set to 0
+  BitRange<false> unset_bits() const { return BitRange<false>(*this); };
+
+  // view on the whole bit map
+  BitMapView view() const;
+  MutableBitMapView view();
+
+  // all the bits are 0
+  virtual bool all0() const {
+    // the unused bits in the last block are always 0
+    return BitMapKernel::active().all0(m_bits, m_table_len);
   };
 
   // all the bits are 1
   virtual bool all1() const {
-    unsigned char c = 0xff;
-    for (size_t i = 0; i < offset(m_size); ++i) {
-      if ((m_bits[i] ^ 0xff) != 0) {
-        return false;
-      }
-    }
-
-    // if has remains
-    if (bits(m_size) != 0) {
-      for (size_t i = bits(m_size); i > 0; --i) {
-        c = (m_bits[m_table_len - 1] >> (i - 1)) & 1;
-        if ((c ^ 1) != 0) {
-          return false;
-        }
-      }
+    if (m_table_len == 0) {
+      return true;
     }
 
-    return true;
+    return (BitMapKernel::active().all1(m_bits, m_table_len - 1) &&
+            m_bits[m_table_len - 1] == tail_mask());
   };
 
   // assignment
   BitMap &operator=(const BitMap &rhs) {
-    copy(rhs);
+    if (this != &rhs) {
+      copy(rhs);
+    }
     return *this;
   }
 
@@ -121,12 +235,7 @@ public:
     if (m_size != rhs.m_size) {
       return false;
     }
-    for (size_t i = 0; i < m_table_len; ++i) {
-      if ((m_bits[i] ^ rhs.m_bits[i]) != 0) {
-        return false;
-      }
-    }
-    return true;
+    return BitMapKernel::active().equal(m_bits, rhs.m_bits, m_table_len);
   }
   bool operator!=(const BitMap &rhs) const { return !(*this == rhs); }
 
@@ -145,191 +254,376 @@ public:
 
   bool operator>=(const BitMap &rhs) const {
     if (m_size >= rhs.m_size && m_table_len >= rhs.m_table_len) {
-      for (size_t i = 0; i < rhs.m_table_len; ++i) {
-        if ((m_bits[i] ^ (m_bits[i] | rhs.m_bits[i])) != 0) {
-          return false;
-        }
-      }
-      return true;
+      return BitMapKernel::active().subset(rhs.m_bits, m_bits,
+                                           rhs.m_table_len);
     }
     return false;
   }
   bool operator<=(const BitMap &rhs) const {
     if (m_size <= rhs.m_size && m_table_len <= rhs.m_table_len) {
-      for (size_t i = 0; i < m_table_len; ++i) {
-        if (rhs.m_bits[i] ^ (m_bits[i] | rhs.m_bits[i])) {
-          return false;
-        }
-      }
-      return true;
+      return BitMapKernel::active().subset(m_bits, rhs.m_bits, m_table_len);
     }
     return false;
   }
 
   // 2 bit maps AND
-  BitMap &operator&(const BitMap &rhs) const {
-    BitMap *value = new BitMap(m_size);
-    size_t i = 0;
-    while (i < m_table_len && i < rhs.m_table_len) {
-      value->m_bits[i] = m_bits[i] & rhs.m_bits[i];
-      ++i;
-    }
-    if (m_table_len > rhs.m_table_len) {
-      while (i++ < m_table_len) {
-        value->m_bits[i] = m_bits[i] & rhs.m_bits[i];
-      }
-    }
-
-    return *value;
+  BitMap operator&(const BitMap &rhs) const {
+    BitMap value(*this);
+    value &= rhs;
+    return value;
   };
   BitMap &operator&=(const BitMap &rhs) {
-    size_t i = 0;
-    while (i < m_table_len && i < rhs.m_table_len) {
-      m_bits[i] &= rhs.m_bits[i];
-      ++i;
-    }
+    size_t const len = std::min(m_table_len, rhs.m_table_len);
+    BitMapKernel::active().and_blocks(m_bits, rhs.m_bits, len);
+    // the blocks not covered by rhs are ANDed with 0
+    memset(m_bits + len, 0, (m_table_len - len) * sizeof(MARKER_BLOCK));
     return *this;
   }
 
   // 2 bit maps OR
-  BitMap &operator|(const BitMap &rhs) const {
-    BitMap *value = new BitMap(m_size);
-    size_t i = 0;
-    while (i < m_table_len && i < rhs.m_table_len) {
-      value->m_bits[i] = m_bits[i] | rhs.m_bits[i];
-      ++i;
-    }
-    if (m_table_len > rhs.m_table_len) {
-      while (i++ < m_table_len) {
-        value->m_bits[i] = m_bits[i] | rhs.m_bits[i];
-      }
-    }
-
-    return *value;
+  BitMap operator|(const BitMap &rhs) const {
+    BitMap value(*this);
+    value |= rhs;
+    return value;
   }
   BitMap &operator|=(const BitMap &rhs) {
-    for (size_t i = 0; i < m_table_len && i < rhs.m_table_len; ++i) {
-      m_bits[i] |= rhs.m_bits[i];
-    }
+    BitMapKernel::active().or_blocks(m_bits, rhs.m_bits,
+                                     std::min(m_table_len, rhs.m_table_len));
+    trim();
 
     return *this;
   };
 
   // 2 bit maps XOR
-  BitMap &operator^(const BitMap &rhs) const {
-    BitMap *value = new BitMap(m_size);
-    size_t i = 0;
-    while (i < m_table_len && i < rhs.m_table_len) {
-      value->m_bits[i] = m_bits[i] ^ rhs.m_bits[i];
-      ++i;
-    }
-    if (m_table_len > rhs.m_table_len) {
-      while (i++ < m_table_len) {
-        value->m_bits[i] = m_bits[i] ^ rhs.m_bits[i];
-      }
-    }
-
-    return *value;
+  BitMap operator^(const BitMap &rhs) const {
+    BitMap value(*this);
+    value ^= rhs;
+    return value;
   };
   BitMap &operator^=(const BitMap &rhs) {
-    size_t i = 0;
-    while (i < m_table_len && i < rhs.m_table_len) {
-      m_bits[i] ^= rhs.m_bits[i];
-      ++i;
-    }
+    BitMapKernel::active().xor_blocks(m_bits, rhs.m_bits,
+                                      std::min(m_table_len, rhs.m_table_len));
+    trim();
     return *this;
   }
 
+  // reuse the storage of a temporary left operand, e.g. a & b & c
+  friend BitMap operator&(BitMap &&lhs, const BitMap &rhs) {
+    lhs &= rhs;
+    return std::move(lhs);
+  };
+  friend BitMap operator|(BitMap &&lhs, const BitMap &rhs) {
+    lhs |= rhs;
+    return std::move(lhs);
+  };
+  friend BitMap operator^(BitMap &&lhs, const BitMap &rhs) {
+    lhs ^= rhs;
+    return std::move(lhs);
+  };
+
+  // number of different bits, same as (*this ^ rhs).count() but without
+  // creating the XOR bit map
+  size_t count_diff(const BitMap &rhs) const {
+    if (m_size != rhs.m_size) { // only comparable on the same size
+      throw std::logic_error("different size bitmaps are not comparable");
+    }
+    return BitMapKernel::active().count_xor(m_bits, rhs.m_bits, m_table_len);
+  };
+
   void diff(const BitMap &rhs, std::vector<size_t> &diff) const {
     if (m_size != rhs.m_size) { // only comparable on the same size
       throw std::logic_error("different size bitmaps are not comparable");
     }
 
     diff.clear();
-    const auto bm_diff = *this ^ rhs;
     for (size_t i = 0; i < m_table_len; ++i) {
-      unsigned char const c = bm_diff.m_bits[i];
-      for (size_t j = 0; j < MARKER_BLOCK_BITS; ++j) {
-        if (((c >> j) & 1) == 1) {
-          diff.push_back(i * MARKER_BLOCK_BITS + j);
-        }
+      MARKER_BLOCK block = m_bits[i] ^ rhs.m_bits[i];
+      while (block != 0) {
+        diff.push_back(i * MARKER_BLOCK_BITS + __builtin_ctzll(block));
+        block &= block - 1; // clear the lowest set bit
       }
     }
   }
 
 private:
   BitMap &copy(const BitMap &rhs) {
+    if (m_table_len != rhs.m_table_len) {
+      release();
+      m_bits = allocate(rhs.m_table_len);
+    }
     m_size = rhs.m_size;
     m_table_len = rhs.m_table_len;
-    if (m_bits) {
+    memcpy(m_bits, rhs.m_bits, m_table_len * sizeof(MARKER_BLOCK));
+    return *this;
+  };
+
+  // the valid bits of the last block
+  MARKER_BLOCK tail_mask() const { return tail_mask(m_size); };
+
+  // the block i with the bits equal to VALUE set to 1
+  template <bool VALUE> MARKER_BLOCK block(const size_t i) const {
+    if (VALUE) {
+      return m_bits[i];
+    }
+    return (i + 1 == m_table_len) ? (~m_bits[i] & tail_mask()) : ~m_bits[i];
+  };
+
+  // the position of the first bit equal to VALUE from pos, npos if none
+  template <bool VALUE> size_t find_from(const size_t pos) const {
+    if (pos >= m_size) {
+      return npos;
+    }
+
+    size_t i = offset(pos);
+    // ignore the bits before pos in the first block
+    MARKER_BLOCK b =
+        block<VALUE>(i) & (~static_cast<MARKER_BLOCK>(0) << bits(pos));
+    while (b == 0) {
+      if (++i == m_table_len) {
+        return npos;
+      }
+      b = block<VALUE>(i);
+    }
+    return (i * MARKER_BLOCK_BITS + __builtin_ctzll(b));
+  };
+
+  // clear the unused bits in the last block, the bits beyond m_size must be
+  // kept as 0 so that the block level compare and count work without masking
+  void trim() {
+    if (m_table_len > 0) {
+      m_bits[m_table_len - 1] &= tail_mask();
+    }
+  };
+
+  MARKER_BLOCK *allocate(const size_t len) {
+    return (len <= INLINE_BLOCKS) ? m_inline : new MARKER_BLOCK[len];
+  };
+  void release() {
+    if (m_bits != m_inline) {
       delete[] m_bits;
     }
-    m_bits = new unsigned char[m_table_len];
-    memcpy(m_bits, rhs.m_bits, m_table_len);
-    return *this;
+    m_bits = m_inline;
+  };
+  // take the bits of rhs, the inline bits are copied, rhs is left empty
+  void steal(BitMap &rhs) {
+    m_size = rhs.m_size;
+    m_table_len = rhs.m_table_len;
+    if (rhs.m_bits == rhs.m_inline) {
+      memcpy(m_inline, rhs.m_inline, m_table_len * sizeof(MARKER_BLOCK));
+      m_bits = m_inline;
+    } else {
+      m_bits = rhs.m_bits;
+    }
+    rhs.m_size = 0;
+    rhs.m_table_len = 0;
+    rhs.m_bits = rhs.m_inline;
   };
 
   size_t m_size;
   size_t m_table_len;
-  unsigned char *m_bits;
+  MARKER_BLOCK *m_bits;
+  MARKER_BLOCK m_inline[INLINE_BLOCKS];
 
   friend class BitMap2;
 };
 
-// 2D bit map
-class BitMap2 {
+// non-owning view on the blocks of a bit map, BLOCK is const MARKER_BLOCK for
+// a read-only view
+// as in BitMap, the unused bits of the last block are always 0
+template <typename BLOCK> class BitMapSpan {
 public:
-  // constructor
-  BitMap2(const size_t row, const size_t col) : m_row(row), m_col(col) {
-    m_bitmap = new BitMap(row * col);
+  BitMapSpan(BLOCK *bits, const size_t size)
+      : m_bits(bits), m_size(size), m_table_len(BitMap::blocks(size)){};
+  // a writable view can be used where a read-only view is expected
+  BitMapSpan(const MutableBitMapView &rhs)
+      : m_bits(rhs.data()), m_size(rhs.size()), m_table_len(rhs.blocks()){};
+
+  size_t size() const { return m_size; };
+  size_t blocks() const { return m_table_len; };
+  BLOCK *data() const { return m_bits; };
+
+  bool get(const size_t pos) const {
+    if (pos < m_size) {
+      return ((m_bits[BitMap::offset(pos)] & BitMap::mask(pos)) != 0);
+    }
+    return false;
   };
-  BitMap2(const BitMap2 &rhs) : m_row(rhs.m_row), m_col(rhs.m_col) {
-    m_bitmap = nullptr;
-    copy(rhs);
+  bool operator[](const size_t pos) const { return get(pos); };
+
+  // writable view only
+  void set(const size_t pos) const {
+    if (pos < m_size) {
+      m_bits[BitMap::offset(pos)] |= BitMap::mask(pos);
+    }
+  };
+  void set() const {
+    if (m_table_len > 0) {
+      memset(m_bits, 0xff, m_table_len * sizeof(MARKER_BLOCK));
+      m_bits[m_table_len - 1] &= BitMap::tail_mask(m_size);
+    }
+  };
+  void reset(const size_t pos) const {
+    if (pos < m_size) {
+      m_bits[BitMap::offset(pos)] &= ~BitMap::mask(pos);
+    }
   };
+  void reset() const { memset(m_bits, 0, m_table_len * sizeof(MARKER_BLOCK)); };
 
-  // destructor
-  ~BitMap2() {
-    if (m_bitmap) {
-      delete m_bitmap;
+  size_t count() const {
+    return BitMapKernel::active().count(m_bits, m_table_len);
+  };
+  bool all0() const {
+    return BitMapKernel::active().all0(m_bits, m_table_len);
+  };
+  bool all1() const {
+    if (m_table_len == 0) {
+      return true;
+    }
+    return (BitMapKernel::active().all1(m_bits, m_table_len - 1) &&
+            m_bits[m_table_len - 1] == BitMap::tail_mask(m_size));
+  };
+
+  bool operator==(const BitMapView &rhs) const {
+    if (m_size != rhs.size()) {
+      return false;
+    }
+    return BitMapKernel::active().equal(m_bits, rhs.data(), m_table_len);
+  };
+  bool operator!=(const BitMapView &rhs) const { return !(*this == rhs); };
+  bool operator>=(const BitMapView &rhs) const {
+    if (m_size < rhs.size()) {
+      return false;
     }
+    return BitMapKernel::active().subset(rhs.data(), m_bits, rhs.blocks());
+  };
+  bool operator<=(const BitMapView &rhs) const {
+    if (m_size > rhs.size()) {
+      return false;
+    }
+    return BitMapKernel::active().subset(m_bits, rhs.data(), m_table_len);
+  };
+
+  // in place row operations, writable view only
+  const BitMapSpan &operator&=(const BitMapView &rhs) const {
+    check(rhs);
+    BitMapKernel::active().and_blocks(m_bits, rhs.data(), m_table_len);
+    return *this;
   };
+  const BitMapSpan &operator|=(const BitMapView &rhs) const {
+    check(rhs);
+    BitMapKernel::active().or_blocks(m_bits, rhs.data(), m_table_len);
+    return *this;
+  };
+
+private:
+  void check(const BitMapView &rhs) const {
+    if (m_size != rhs.size()) {
+      throw std::out_of_range("can't operate bit maps with different size");
+    }
+  };
+
+  BLOCK *m_bits;
+  size_t m_size;
+  size_t m_table_len;
+};
+
+inline BitMapView BitMap::view() const { return BitMapView(m_bits, m_size); }
+inline MutableBitMapView BitMap::view() {
+  return MutableBitMapView(m_bits, m_size);
+}
+
+// 2D bit map interface, implemented by the dense BitMap2 and the compressed
+// RoaringBitMap2 so the user can pick the storage by the graph size
+class IBitMap2 {
+public:
+  virtual ~IBitMap2() = default;
+
+  virtual void set() = 0;
+  virtual void set(const size_t i, const size_t j) = 0;
+  virtual void reset() = 0;
+  virtual void reset(const size_t i, const size_t j) = 0;
+  virtual bool get(const size_t i, const size_t j) const = 0;
+  virtual size_t size() const = 0;
+  virtual size_t rows() const = 0;
+  virtual size_t cols() const = 0;
+  virtual bool all0() const = 0;
+  virtual bool all1() const = 0;
+  // bytes used to store the bits
+  virtual size_t memory() const = 0;
+};
+
+// 2D bit map
+// every row starts at a block boundary, so a row can be accessed and operated
+// in place through a view, the padding bits at the end of the rows are 0
+class BitMap2 : public IBitMap2 {
+public:
+  // constructor
+  BitMap2(const size_t row, const size_t col)
+      : m_row(row), m_col(col), m_stride(BitMap::blocks(col)),
+        m_bitmap(row * m_stride * MARKER_BLOCK_BITS){};
+  BitMap2(const BitMap2 &rhs) = default;
+  BitMap2(BitMap2 &&rhs) noexcept = default;
+
+  // destructor
+  virtual ~BitMap2() = default;
 
   // read-write
-  virtual void set() { m_bitmap->set(); };
-  virtual void set(const size_t i, const size_t j) {
+  void set() override {
+    for (size_t i = 0; i < m_row; ++i) {
+      row(i).set();
+    }
+  };
+  void set(const size_t i, const size_t j) override {
     if (i < m_row && j < m_col) {
-      m_bitmap->set(i * m_col + j);
+      m_bitmap.set(position(i, j));
     }
   };
-  void reset() { m_bitmap->reset(); };
-  void reset(const size_t i, const size_t j) {
+  void reset() override { m_bitmap.reset(); };
+  void reset(const size_t i, const size_t j) override {
     if (i < m_row && j < m_col) {
-      m_bitmap->reset(i * m_col + j);
+      m_bitmap.reset(position(i, j));
     }
   };
-  virtual size_t size() const { return m_bitmap->size(); };
-  virtual size_t rows() const { return m_row; };
-  virtual size_t cols() const { return m_col; };
-  virtual bool get(const size_t i, const size_t j) const {
+  size_t size() const override { return m_row * m_col; };
+  size_t rows() const override { return m_row; };
+  size_t cols() const override { return m_col; };
+  size_t memory() const override {
+    return m_row * m_stride * sizeof(MARKER_BLOCK);
+  };
+  bool get(const size_t i, const size_t j) const override {
     if (i < m_row && j < m_col) {
-      return m_bitmap->get(i * m_col + j);
+      return m_bitmap.get(position(i, j));
     }
     return false;
   };
-  virtual const BitMap &operator[](const size_t row) const {
+  virtual BitMapView operator[](const size_t row) const {
     return get_row(row);
   };
 
+  // zero-copy row access
+  BitMapView row(const size_t row) const { return get_row(row); };
+  MutableBitMapView row(const size_t row) {
+    check_row(row);
+    return MutableBitMapView(m_bitmap.m_bits + row * m_stride, m_col);
+  };
+
   // assignment
-  virtual BitMap2 &operator=(const BitMap2 &rhs) { return copy(rhs); };
+  BitMap2 &operator=(const BitMap2 &rhs) = default;
+  BitMap2 &operator=(BitMap2 &&rhs) noexcept = default;
 
   // compare
-  virtual bool all0() const { return m_bitmap->all0(); };
-  virtual bool all1() const { return m_bitmap->all1(); };
+  bool all0() const override { return m_bitmap.all0(); };
+  bool all1() const override {
+    for (size_t i = 0; i < m_row; ++i) {
+      if (!get_row(i).all1()) {
+        return false;
+      }
+    }
+    return true;
+  };
   virtual bool operator==(const BitMap2 &rhs) const {
     if (m_row == rhs.m_row && m_col == rhs.m_col) {
-      return *m_bitmap == *rhs.m_bitmap;
+      return m_bitmap == rhs.m_bitmap;
     }
     return false;
   };
@@ -350,9 +644,12 @@ public:
     if (m_row < rhs.m_row || m_col < rhs.m_col) {
       return false;
     }
+    if (m_row == rhs.m_row && m_col == rhs.m_col) {
+      return (m_bitmap >= rhs.m_bitmap);
+    }
 
     size_t row = 0;
-    while (row < rhs.m_row && get_row(row) >= rhs[row]) {
+    while (row < rhs.m_row && get_row(row) >= rhs.get_row(row)) {
       ++row;
     }
 
@@ -362,117 +659,69 @@ public:
     if (m_row > rhs.m_row || m_col > rhs.m_col) {
       return false;
     }
+    if (m_row == rhs.m_row && m_col == rhs.m_col) {
+      return (m_bitmap <= rhs.m_bitmap);
+    }
 
     size_t row = 0;
-    while (row < rhs.m_row && get_row(row) <= rhs[row]) {
+    while (row < m_row && get_row(row) <= rhs.get_row(row)) {
       ++row;
     }
 
-    return (row == rhs.m_row);
+    return (row == m_row);
   };
 
   // manipulate
-  virtual BitMap2 &operator&(const BitMap2 &rhs) const {
-    if (m_row != rhs.m_row || m_col != rhs.m_col) {
-      throw std::out_of_range("can't compare bit map with different size");
-    }
-
-    BitMap2 *value = new BitMap2(m_row, m_col);
-    for (size_t i = 0; i < m_bitmap->m_table_len; ++i) {
-      value->m_bitmap->m_bits[i] =
-          m_bitmap->m_bits[i] & rhs.m_bitmap->m_bits[i];
-    }
-
-    return *value;
+  BitMap2 operator&(const BitMap2 &rhs) const {
+    BitMap2 value(*this);
+    value &= rhs;
+    return value;
   };
   virtual BitMap2 &operator&=(const BitMap2 &rhs) {
     if (m_row != rhs.m_row || m_col != rhs.m_col) {
       throw std::out_of_range("can't compare bit map with different size");
     }
 
-    for (size_t i = 0; i < m_bitmap->m_table_len; ++i) {
-      m_bitmap->m_bits[i] &= rhs.m_bitmap->m_bits[i];
-    }
+    m_bitmap &= rhs.m_bitmap;
 
     return *this;
   };
-  virtual BitMap2 &operator|(const BitMap2 &rhs) const {
-    if (m_row != rhs.m_row || m_col != rhs.m_col) {
-      throw std::out_of_range("can't compare bit map with different size");
-    }
-
-    BitMap2 *value = new BitMap2(m_row, m_col);
-    for (size_t i = 0; i < m_bitmap->m_table_len; ++i) {
-      value->m_bitmap->m_bits[i] =
-          m_bitmap->m_bits[i] | rhs.m_bitmap->m_bits[i];
-    }
-
-    return *value;
+  BitMap2 operator|(const BitMap2 &rhs) const {
+    BitMap2 value(*this);
+    value |= rhs;
+    return value;
   };
   virtual BitMap2 &operator|=(const BitMap2 &rhs) {
     if (m_row != rhs.m_row || m_col != rhs.m_col) {
       throw std::out_of_range("can't compare bit map with different size");
     }
 
-    for (size_t i = 0; i < m_bitmap->m_table_len; ++i) {
-      m_bitmap->m_bits[i] |= rhs.m_bitmap->m_bits[i];
-    }
+    m_bitmap |= rhs.m_bitmap;
 
     return *this;
   };
 
 private:
-  BitMap2 &copy(const BitMap2 &rhs) {
-    m_row = rhs.m_row;
-    m_col = rhs.m_col;
-    if (m_bitmap) {
-      delete m_bitmap;
-    }
-    m_bitmap = new BitMap(*rhs.m_bitmap);
-    return *this;
-  }
+  size_t position(const size_t i, const size_t j) const {
+    return (i * m_stride * MARKER_BLOCK_BITS + j);
+  };
 
-  virtual const BitMap &get_row(const size_t row) const {
+  void check_row(const size_t row) const {
     if (row >= m_row) {
       throw std::out_of_range("2D bit map line access out of range");
     }
+  };
 
-    // get one line from a 2 dimention bit map
-    // tricky here is the bits saved in the 2D bit map is not row aligned
-    // so we need to get the value bit by bit
-    size_t const start_bit = row * m_col;
-    size_t const start_block = BitMap::offset(start_bit);
-    size_t const moving_bits = BitMap::bits(start_bit);
-
-    // create a new bit map
-    BitMap *rhs = new BitMap(m_col);
-    // copy bit blocks from bitmap2 to bitmap memory
-    memcpy(rhs->m_bits, m_bitmap->m_bits + start_block, rhs->m_table_len);
-    // if not block aligned, do bit moving
-    if (moving_bits > 0) {
-      size_t i = 0;
-      while (i < rhs->m_table_len - 1) {
-        // move the original bits left
-        rhs->m_bits[i] = rhs->m_bits[i] << moving_bits;
-        // move the rest bits from next block to the current block
-        unsigned char const c =
-            rhs->m_bits[i + 1] >> (MARKER_BLOCK_BITS - moving_bits);
-        rhs->m_bits[i] |= c;
-        ++i;
-      }
-      // deal the last block
-      unsigned char c = m_bitmap->m_bits[start_block + 1];
-      c = c >> (MARKER_BLOCK_BITS - moving_bits);
-      rhs->m_bits[i] |= c;
-    }
-
-    return *rhs;
+  BitMapView get_row(const size_t row) const {
+    check_row(row);
+    return BitMapView(m_bitmap.m_bits + row * m_stride, m_col);
   };
 
   BitMap2();
   size_t m_row;
   size_t m_col;
-  BitMap *m_bitmap;
+  size_t m_stride; // blocks per row
+  BitMap m_bitmap;
 };
 
 #endif
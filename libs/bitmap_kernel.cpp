@@ -0,0 +1,370 @@
+#include "bitmap_kernel.h"
+
+#include <atomic>
+#include <cstddef>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CASEGEN_X86_KERNELS
+#endif
+
+namespace {
+
+const MARKER_BLOCK ALL_ONES = ~static_cast<MARKER_BLOCK>(0);
+
+// scalar kernels, also used for the tails of the vectorized ones
+
+void scalar_and(MARKER_BLOCK *dst, const MARKER_BLOCK *src, size_t len) {
+  for (size_t i = 0; i < len; ++i) {
+    dst[i] &= src[i];
+  }
+}
+
+void scalar_or(MARKER_BLOCK *dst, const MARKER_BLOCK *src, size_t len) {
+  for (size_t i = 0; i < len; ++i) {
+    dst[i] |= src[i];
+  }
+}
+
+void scalar_xor(MARKER_BLOCK *dst, const MARKER_BLOCK *src, size_t len) {
+  for (size_t i = 0; i < len; ++i) {
+    dst[i] ^= src[i];
+  }
+}
+
+bool scalar_equal(const MARKER_BLOCK *a, const MARKER_BLOCK *b, size_t len) {
+  for (size_t i = 0; i < len; ++i) {
+    if (a[i] != b[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool scalar_subset(const MARKER_BLOCK *sub, const MARKER_BLOCK *super,
+                   size_t len) {
+  for (size_t i = 0; i < len; ++i) {
+    if ((sub[i] & ~super[i]) != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool scalar_all0(const MARKER_BLOCK *a, size_t len) {
+  for (size_t i = 0; i < len; ++i) {
+    if (a[i] != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool scalar_all1(const MARKER_BLOCK *a, size_t len) {
+  for (size_t i = 0; i < len; ++i) {
+    if (a[i] != ALL_ONES) {
+      return false;
+    }
+  }
+  return true;
+}
+
+size_t scalar_count(const MARKER_BLOCK *a, size_t len) {
+  size_t n = 0;
+  for (size_t i = 0; i < len; ++i) {
+    n += __builtin_popcountll(a[i]);
+  }
+  return n;
+}
+
+size_t scalar_count_xor(const MARKER_BLOCK *a, const MARKER_BLOCK *b,
+                        size_t len) {
+  size_t n = 0;
+  for (size_t i = 0; i < len; ++i) {
+    n += __builtin_popcountll(a[i] ^ b[i]);
+  }
+  return n;
+}
+
+const BitMapKernel SCALAR_KERNEL = {
+    BitMapKernel::ISA_SCALAR, "scalar", scalar_and, scalar_or, scalar_xor,
+    scalar_equal, scalar_subset, scalar_all0, scalar_all1, scalar_count,
+    scalar_count_xor};
+
+#ifdef CASEGEN_X86_KERNELS
+
+// SSE2, 2 blocks per instruction
+
+const size_t SSE2_STEP = sizeof(__m128i) / sizeof(MARKER_BLOCK);
+
+__attribute__((target("sse2"))) bool sse2_zero(const __m128i x) {
+  return (_mm_movemask_epi8(_mm_cmpeq_epi8(x, _mm_setzero_si128())) ==
+          0xffff);
+}
+
+__attribute__((target("sse2"))) void
+sse2_and(MARKER_BLOCK *dst, const MARKER_BLOCK *src, size_t len) {
+  size_t i = 0;
+  for (; i + SSE2_STEP <= len; i += SSE2_STEP) {
+    __m128i *d = reinterpret_cast<__m128i *>(dst + i);
+    __m128i const s =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+    _mm_storeu_si128(d, _mm_and_si128(_mm_loadu_si128(d), s));
+  }
+  scalar_and(dst + i, src + i, len - i);
+}
+
+__attribute__((target("sse2"))) void
+sse2_or(MARKER_BLOCK *dst, const MARKER_BLOCK *src, size_t len) {
+  size_t i = 0;
+  for (; i + SSE2_STEP <= len; i += SSE2_STEP) {
+    __m128i *d = reinterpret_cast<__m128i *>(dst + i);
+    __m128i const s =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+    _mm_storeu_si128(d, _mm_or_si128(_mm_loadu_si128(d), s));
+  }
+  scalar_or(dst + i, src + i, len - i);
+}
+
+__attribute__((target("sse2"))) void
+sse2_xor(MARKER_BLOCK *dst, const MARKER_BLOCK *src, size_t len) {
+  size_t i = 0;
+  for (; i + SSE2_STEP <= len; i += SSE2_STEP) {
+    __m128i *d = reinterpret_cast<__m128i *>(dst + i);
+    __m128i const s =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+    _mm_storeu_si128(d, _mm_xor_si128(_mm_loadu_si128(d), s));
+  }
+  scalar_xor(dst + i, src + i, len - i);
+}
+
+__attribute__((target("sse2"))) bool
+sse2_equal(const MARKER_BLOCK *a, const MARKER_BLOCK *b, size_t len) {
+  size_t i = 0;
+  for (; i + SSE2_STEP <= len; i += SSE2_STEP) {
+    __m128i const x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+    __m128i const y = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i));
+    if (!sse2_zero(_mm_xor_si128(x, y))) {
+      return false;
+    }
+  }
+  return scalar_equal(a + i, b + i, len - i);
+}
+
+__attribute__((target("sse2"))) bool
+sse2_subset(const MARKER_BLOCK *sub, const MARKER_BLOCK *super, size_t len) {
+  size_t i = 0;
+  for (; i + SSE2_STEP <= len; i += SSE2_STEP) {
+    __m128i const x =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(sub + i));
+    __m128i const y =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(super + i));
+    if (!sse2_zero(_mm_andnot_si128(y, x))) {
+      return false;
+    }
+  }
+  return scalar_subset(sub + i, super + i, len - i);
+}
+
+__attribute__((target("sse2"))) bool sse2_all0(const MARKER_BLOCK *a,
+                                               size_t len) {
+  size_t i = 0;
+  for (; i + SSE2_STEP <= len; i += SSE2_STEP) {
+    if (!sse2_zero(
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i)))) {
+      return false;
+    }
+  }
+  return scalar_all0(a + i, len - i);
+}
+
+__attribute__((target("sse2"))) bool sse2_all1(const MARKER_BLOCK *a,
+                                               size_t len) {
+  __m128i const ones = _mm_set1_epi32(-1);
+  size_t i = 0;
+  for (; i + SSE2_STEP <= len; i += SSE2_STEP) {
+    __m128i const x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+    if (!sse2_zero(_mm_xor_si128(x, ones))) {
+      return false;
+    }
+  }
+  return scalar_all1(a + i, len - i);
+}
+
+const BitMapKernel SSE2_KERNEL = {
+    BitMapKernel::ISA_SSE2, "sse2", sse2_and, sse2_or, sse2_xor, sse2_equal,
+    sse2_subset, sse2_all0, sse2_all1, scalar_count, scalar_count_xor};
+
+// AVX2, 4 blocks per instruction
+
+const size_t AVX2_STEP = sizeof(__m256i) / sizeof(MARKER_BLOCK);
+
+__attribute__((target("avx2"))) void
+avx2_and(MARKER_BLOCK *dst, const MARKER_BLOCK *src, size_t len) {
+  size_t i = 0;
+  for (; i + AVX2_STEP <= len; i += AVX2_STEP) {
+    __m256i *d = reinterpret_cast<__m256i *>(dst + i);
+    __m256i const s =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+    _mm256_storeu_si256(d, _mm256_and_si256(_mm256_loadu_si256(d), s));
+  }
+  scalar_and(dst + i, src + i, len - i);
+}
+
+__attribute__((target("avx2"))) void
+avx2_or(MARKER_BLOCK *dst, const MARKER_BLOCK *src, size_t len) {
+  size_t i = 0;
+  for (; i + AVX2_STEP <= len; i += AVX2_STEP) {
+    __m256i *d = reinterpret_cast<__m256i *>(dst + i);
+    __m256i const s =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+    _mm256_storeu_si256(d, _mm256_or_si256(_mm256_loadu_si256(d), s));
+  }
+  scalar_or(dst + i, src + i, len - i);
+}
+
+__attribute__((target("avx2"))) void
+avx2_xor(MARKER_BLOCK *dst, const MARKER_BLOCK *src, size_t len) {
+  size_t i = 0;
+  for (; i + AVX2_STEP <= len; i += AVX2_STEP) {
+    __m256i *d = reinterpret_cast<__m256i *>(dst + i);
+    __m256i const s =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+    _mm256_storeu_si256(d, _mm256_xor_si256(_mm256_loadu_si256(d), s));
+  }
+  scalar_xor(dst + i, src + i, len - i);
+}
+
+__attribute__((target("avx2"))) bool
+avx2_equal(const MARKER_BLOCK *a, const MARKER_BLOCK *b, size_t len) {
+  size_t i = 0;
+  for (; i + AVX2_STEP <= len; i += AVX2_STEP) {
+    __m256i const x =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+    __m256i const y =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i));
+    __m256i const z = _mm256_xor_si256(x, y);
+    if (!_mm256_testz_si256(z, z)) {
+      return false;
+    }
+  }
+  return scalar_equal(a + i, b + i, len - i);
+}
+
+__attribute__((target("avx2"))) bool
+avx2_subset(const MARKER_BLOCK *sub, const MARKER_BLOCK *super, size_t len) {
+  size_t i = 0;
+  for (; i + AVX2_STEP <= len; i += AVX2_STEP) {
+    __m256i const x =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(sub + i));
+    __m256i const y =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(super + i));
+    // testc(y, x) is set when x & ~y == 0
+    if (!_mm256_testc_si256(y, x)) {
+      return false;
+    }
+  }
+  return scalar_subset(sub + i, super + i, len - i);
+}
+
+__attribute__((target("avx2"))) bool avx2_all0(const MARKER_BLOCK *a,
+                                               size_t len) {
+  size_t i = 0;
+  for (; i + AVX2_STEP <= len; i += AVX2_STEP) {
+    __m256i const x =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+    if (!_mm256_testz_si256(x, x)) {
+      return false;
+    }
+  }
+  return scalar_all0(a + i, len - i);
+}
+
+__attribute__((target("avx2"))) bool avx2_all1(const MARKER_BLOCK *a,
+                                               size_t len) {
+  __m256i const ones = _mm256_set1_epi32(-1);
+  size_t i = 0;
+  for (; i + AVX2_STEP <= len; i += AVX2_STEP) {
+    __m256i const x =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+    if (!_mm256_testc_si256(x, ones)) {
+      return false;
+    }
+  }
+  return scalar_all1(a + i, len - i);
+}
+
+// every cpu with AVX2 has the popcnt instruction
+__attribute__((target("avx2,popcnt"))) size_t avx2_count(const MARKER_BLOCK *a,
+                                                         size_t len) {
+  size_t n = 0;
+  for (size_t i = 0; i < len; ++i) {
+    n += __builtin_popcountll(a[i]);
+  }
+  return n;
+}
+
+__attribute__((target("avx2,popcnt"))) size_t
+avx2_count_xor(const MARKER_BLOCK *a, const MARKER_BLOCK *b, size_t len) {
+  size_t n = 0;
+  for (size_t i = 0; i < len; ++i) {
+    n += __builtin_popcountll(a[i] ^ b[i]);
+  }
+  return n;
+}
+
+const BitMapKernel AVX2_KERNEL = {
+    BitMapKernel::ISA_AVX2, "avx2", avx2_and, avx2_or, avx2_xor, avx2_equal,
+    avx2_subset, avx2_all0, avx2_all1, avx2_count, avx2_count_xor};
+
+#endif
+
+const BitMapKernel *detect() {
+  const BitMapKernel *kernel = BitMapKernel::select(BitMapKernel::ISA_AVX2);
+  if (nullptr == kernel) {
+    kernel = BitMapKernel::select(BitMapKernel::ISA_SSE2);
+  }
+  if (nullptr == kernel) {
+    kernel = &SCALAR_KERNEL;
+  }
+  return kernel;
+}
+
+std::atomic<const BitMapKernel *> s_active(nullptr);
+
+} // namespace
+
+const BitMapKernel &BitMapKernel::active() {
+  const BitMapKernel *kernel = s_active.load(std::memory_order_relaxed);
+  if (nullptr == kernel) {
+    kernel = detect();
+    s_active.store(kernel, std::memory_order_relaxed);
+  }
+  return *kernel;
+}
+
+const BitMapKernel *BitMapKernel::select(ISA isa) {
+  switch (isa) {
+  case ISA_SCALAR:
+    return &SCALAR_KERNEL;
+#ifdef CASEGEN_X86_KERNELS
+  case ISA_SSE2:
+    return __builtin_cpu_supports("sse2") ? &SSE2_KERNEL : nullptr;
+  case ISA_AVX2:
+    return (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt"))
+               ? &AVX2_KERNEL
+               : nullptr;
+#endif
+  default:
+    return nullptr;
+  }
+}
+
+bool BitMapKernel::use(ISA isa) {
+  const BitMapKernel *kernel = select(isa);
+  if (nullptr == kernel) {
+    return false;
+  }
+  s_active.store(kernel, std::memory_order_relaxed);
+  return true;
+}
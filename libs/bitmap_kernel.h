@@ -0,0 +1,50 @@
+#ifndef CASEGEN_BITMAP_KERNEL_H_
+#define CASEGEN_BITMAP_KERNEL_H_
+
+#include <cstddef>
+#include <cstdint>
+
+typedef uint64_t MARKER_BLOCK;
+
+// block level kernels behind the bulk operations of BitMap and BitMap2
+// every instruction set provides the same functions, the best one supported
+// by the running cpu is selected on first use
+struct BitMapKernel {
+  enum ISA { ISA_SCALAR = 0, ISA_SSE2, ISA_AVX2 };
+
+  ISA isa;
+  const char *name;
+
+  // dst op= src
+  void (*and_blocks)(MARKER_BLOCK *dst, const MARKER_BLOCK *src, size_t len);
+  void (*or_blocks)(MARKER_BLOCK *dst, const MARKER_BLOCK *src, size_t len);
+  void (*xor_blocks)(MARKER_BLOCK *dst, const MARKER_BLOCK *src, size_t len);
+
+  // a == b
+  bool (*equal)(const MARKER_BLOCK *a, const MARKER_BLOCK *b, size_t len);
+  // all the bits of sub are set in super
+  bool (*subset)(const MARKER_BLOCK *sub, const MARKER_BLOCK *super,
+                 size_t len);
+  // all the blocks are 0
+  bool (*all0)(const MARKER_BLOCK *a, size_t len);
+  // all the blocks are ~0
+  bool (*all1)(const MARKER_BLOCK *a, size_t len);
+  // number of bits set to 1
+  size_t (*count)(const MARKER_BLOCK *a, size_t len);
+  // number of bits set to 1 in a ^ b, without storing a ^ b
+  size_t (*count_xor)(const MARKER_BLOCK *a, const MARKER_BLOCK *b,
+                      size_t len);
+
+  // the kernel used by the bit maps
+  static const BitMapKernel &active();
+
+  // the kernel of the given instruction set, nullptr if the cpu (or the
+  // compiler) does not support it
+  static const BitMapKernel *select(ISA isa);
+
+  // force the bit maps to use the given instruction set, return false if it
+  // is not supported
+  static bool use(ISA isa);
+};
+
+#endif
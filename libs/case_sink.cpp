@@ -0,0 +1,135 @@
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <fcntl.h>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+
+#include "case_sink.h"
+
+using namespace std;
+
+namespace {
+
+// a prefix, a sign and the digits of an int
+const size_t NAME_SIZE = 2 + numeric_limits<int>::digits10 + 1;
+
+} // namespace
+
+StreamSink::StreamSink(ostream *out, int fd)
+    : m_out(out), m_fd(fd), m_buffer(BUFFER_SIZE) {}
+
+StreamSink::~StreamSink() {
+  try {
+    flush();
+  } catch (const runtime_error &e) {
+    cerr << e.what() << '\n';
+  }
+}
+
+void StreamSink::beginCase(const Graph &g, const VERTEX_ID start) {
+  // the cases are separated by a new line, the last one is not ended
+  if (m_cases++ > 0) {
+    put("\n", 1);
+  }
+  m_graph = &g;
+  Vertex *const v = g.getVertex(start);
+  name('S', v->id, v->content);
+}
+
+void StreamSink::append(const LINK_ID link) {
+  Link *const l = m_graph->getLink(link);
+  put("--", 2);
+  name('E', l->edge.type, l->edge.content);
+  put("-->", 3);
+  name('S', l->target.id, l->target.content);
+}
+
+void StreamSink::flush() {
+  size_t const used = m_used;
+  m_used = 0;
+  write(m_buffer.data(), used);
+}
+
+void StreamSink::finish() {
+  if (m_cases > 0) {
+    put("\n", 1);
+  }
+  flush();
+}
+
+void StreamSink::write(const char *text, const size_t length) {
+  if (length == 0) {
+    return;
+  }
+  if (m_fd < 0) {
+    m_out->write(text, length);
+    return;
+  }
+
+  // what is already in the stream goes first
+  if (m_out != nullptr) {
+    m_out->flush();
+  }
+  size_t left = length;
+  while (left > 0) {
+    ssize_t const written = ::write(m_fd, text, left);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw runtime_error("can not write the cases");
+    }
+    text += written;
+    left -= written;
+  }
+}
+
+void StreamSink::name(const char prefix, const int number,
+                      const string &content) {
+  if (!content.empty()) {
+    put(content.data(), content.size());
+    return;
+  }
+  if (m_used + NAME_SIZE > m_buffer.size()) {
+    flush();
+  }
+  char *const first = m_buffer.data() + m_used;
+  *first = prefix;
+  m_used = to_chars(first + 1, first + NAME_SIZE, number).ptr - m_buffer.data();
+}
+
+void StreamSink::put(const char *text, const size_t length) {
+  if (m_used + length > m_buffer.size()) {
+    flush();
+    if (length > m_buffer.size()) {
+      // too long to be buffered
+      write(text, length);
+      return;
+    }
+  }
+  copy(text, text + length, m_buffer.data() + m_used);
+  m_used += length;
+}
+
+StdoutSink::StdoutSink() : StreamSink(&cout, STDOUT_FILENO) {}
+
+FileSink::FileSink(const string &file)
+    : StreamSink(nullptr, ::open(file.c_str(), O_WRONLY | O_CREAT | O_TRUNC,
+                                 0644)) {
+  if (m_fd < 0) {
+    throw runtime_error("can not create " + file);
+  }
+}
+
+FileSink::~FileSink() {
+  try {
+    flush();
+  } catch (const runtime_error &e) {
+    cerr << e.what() << '\n';
+  }
+  ::close(m_fd);
+}
@@ -0,0 +1,118 @@
+#ifndef CASEGEN_CASE_SINK_H_
+#define CASEGEN_CASE_SINK_H_
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "graph.h"
+
+// receives the cases of a traveller as soon as they are found, a case is a
+// start vertex and the ids of the links walked from it
+// a long case (an Euler tour) is handed over link by link between beginCase
+// and endCase, a path at once by emit, the sink does all the formatting
+// a sink is used by one thread at a time
+class CaseSink {
+public:
+  CaseSink() = default;
+  virtual ~CaseSink() = default;
+  CaseSink(const CaseSink &rhs) = delete;
+  CaseSink &operator=(const CaseSink &rhs) = delete;
+
+  virtual void beginCase(const Graph &g, const VERTEX_ID start) = 0;
+  virtual void append(const LINK_ID link) = 0;
+  virtual void endCase() = 0;
+
+  // a whole case, the links are a span of count ids
+  virtual void emit(const Graph &g, const VERTEX_ID start,
+                    const LINK_ID *links, const size_t count) {
+    beginCase(g, start);
+    for (size_t i = 0; i < count; ++i) {
+      append(links[i]);
+    }
+    endCase();
+  };
+};
+
+// the cases as text, S0--E1-->S2, one case per line
+// the text is formatted into a big buffer, numbers by to_chars, and written
+// out once the buffer is full, on flush() and by the destructor, to the
+// stream or by write(2) on a file descriptor
+// throws runtime_error if the file descriptor can not be written
+class StreamSink : public CaseSink {
+public:
+  static constexpr size_t BUFFER_SIZE = 1 << 20;
+
+  explicit StreamSink(std::ostream &out) : StreamSink(&out, -1){};
+  ~StreamSink() override;
+
+  void beginCase(const Graph &g, const VERTEX_ID start) override;
+  void append(const LINK_ID link) override;
+  void endCase() override{};
+
+  // write out the text buffered
+  void flush();
+  // end the last case with a new line and write out the text, once all the
+  // cases are handed over
+  void finish();
+
+  size_t cases() const { return m_cases; };
+
+protected:
+  // fd >= 0: the text is written to fd, out is flushed before
+  StreamSink(std::ostream *out, int fd);
+
+  std::ostream *m_out;
+  int m_fd;
+
+private:
+  // the content of a vertex or an edge if it has one, or prefix and number
+  void name(const char prefix, const int number, const std::string &content);
+  void put(const char *text, const size_t length);
+  // to the stream, or by write(2) to the file descriptor
+  void write(const char *text, const size_t length);
+
+  const Graph *m_graph{nullptr};
+  size_t m_cases{0};
+  std::vector<char> m_buffer;
+  size_t m_used{0};
+};
+
+// the cases as text on the standard output, written to its file descriptor
+class StdoutSink : public StreamSink {
+public:
+  StdoutSink();
+};
+
+// the cases as text in a file, throws runtime_error if it can not be created
+class FileSink : public StreamSink {
+public:
+  explicit FileSink(const std::string &file);
+  ~FileSink() override;
+};
+
+// the cases kept as link ids
+class MemorySink : public CaseSink {
+public:
+  struct Case {
+    VERTEX_ID start;
+    std::vector<LINK_ID> links;
+  };
+
+  void beginCase(const Graph &, const VERTEX_ID start) override {
+    m_cases.push_back(Case{start, {}});
+  };
+  void append(const LINK_ID link) override {
+    m_cases.back().links.push_back(link);
+  };
+  void endCase() override{};
+
+  const std::vector<Case> &cases() const { return m_cases; };
+  void clear() { m_cases.clear(); };
+
+private:
+  std::vector<Case> m_cases;
+};
+
+#endif
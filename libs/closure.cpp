@@ -0,0 +1,98 @@
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+#include "closure.h"
+
+using namespace std;
+
+namespace {
+
+void check(const BitMap2 &m) {
+  if (m.rows() != m.cols()) {
+    throw logic_error("transitive closure needs a square bit matrix");
+  }
+}
+
+} // namespace
+
+void BitMatrixClosure::warshall(BitMap2 &m) {
+  check(m);
+
+  const size_t n = m.rows();
+  for (size_t k = 0; k < n; ++k) {
+    BitMapView const pivot = m.row(k);
+    for (size_t i = 0; i < n; ++i) {
+      if (i != k && m.get(i, k)) {
+        m.row(i) |= pivot;
+      }
+    }
+  }
+}
+
+void BitMatrixClosure::fourRussians(BitMap2 &m) {
+  check(m);
+
+  const size_t n = m.rows();
+  const size_t stride = BitMap::blocks(n);
+  const size_t combinations = 1 << BLOCK_PIVOTS;
+  const BitMapKernel &kernel = BitMapKernel::active();
+
+  // union of the pivot rows for every combination of the pivots in a block,
+  // built on demand, entry 0 is the empty union
+  vector<MARKER_BLOCK> table(combinations * stride);
+  vector<bool> built(combinations);
+
+  for (size_t k0 = 0; k0 < n; k0 += BLOCK_PIVOTS) {
+    const size_t pivots = min(BLOCK_PIVOTS, n - k0);
+
+    // plain Warshall of the block pivots on the block rows
+    for (size_t k = k0; k < k0 + pivots; ++k) {
+      BitMapView const pivot = m.row(k);
+      for (size_t i = k0; i < k0 + pivots; ++i) {
+        if (i != k && m.get(i, k)) {
+          m.row(i) |= pivot;
+        }
+      }
+    }
+
+    // a closed pivot row contains the rows of the pivots it reaches, so the
+    // union of the rows of the pivots a row reaches directly is enough
+    fill(built.begin(), built.end(), false);
+    fill(table.begin(), table.begin() + stride, 0);
+    built[0] = true;
+    for (size_t i = 0; i < n; ++i) {
+      if (i >= k0 && i < k0 + pivots) {
+        continue;
+      }
+
+      MutableBitMapView const row = m.row(i);
+      // k0 is a multiple of 8, the pivot columns never cross a block
+      const size_t mask =
+          (row.data()[BitMap::offset(k0)] >> BitMap::bits(k0)) &
+          (combinations - 1);
+      if (mask == 0) {
+        continue;
+      }
+
+      // build the missing entries from the lowest pivot up
+      if (!built[mask]) {
+        size_t partial = 0;
+        for (size_t rest = mask; rest != 0; rest &= rest - 1) {
+          size_t const next = partial | (rest & (~rest + 1));
+          if (!built[next]) {
+            MARKER_BLOCK *const entry = &table[next * stride];
+            copy(&table[partial * stride], &table[partial * stride] + stride,
+                 entry);
+            kernel.or_blocks(
+                entry, m.row(k0 + __builtin_ctzll(rest)).data(), stride);
+            built[next] = true;
+          }
+          partial = next;
+        }
+      }
+
+      kernel.or_blocks(row.data(), &table[mask * stride], stride);
+    }
+  }
+}
@@ -0,0 +1,25 @@
+#ifndef CASEGEN_CLOSURE_H_
+#define CASEGEN_CLOSURE_H_
+
+#include "bitmap.h"
+
+// transitive closure of a square bit matrix, in place
+// m[i][j] is the edge i->j on input, and on return m[i][j] is 1 iff j can be
+// reached from i by one or more edges, the same as the BFS scan of Graph
+// both work a row at a time with word-parallel ORs on the row-aligned BitMap2
+class BitMatrixClosure {
+public:
+  // Warshall: for every pivot k, every row reaching k takes the row of k
+  static void warshall(BitMap2 &m);
+
+  // Warshall by blocks of 8 pivots (Four Russians)
+  // the 8 pivot rows of a block are closed first, then every other row ORs
+  // the precomputed union of the pivot rows it reaches, selected by the 8
+  // bits of the row in the pivot columns, so a row is touched once per block
+  // instead of up to 8 times
+  static void fourRussians(BitMap2 &m);
+
+  static constexpr size_t BLOCK_PIVOTS = 8;
+};
+
+#endif
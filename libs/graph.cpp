@@ -1,44 +1,98 @@
 #include <algorithm>
+#include <atomic>
 #include <cstring>
 #include <fstream>
 #include <iostream>
-#include <queue>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "bitmap.h"
+#include "closure.h"
 #include "graph.h"
-#include "traveller.h"
+#include "msbfs.h"
+#include "roaring_bitmap.h"
+#include "transport.h"
+#include "workers.h"
 
 using namespace std;
 
-Graph::Graph() : m_reach_table(nullptr) {}
+namespace {
 
-Graph::~Graph() {
-  for (VERTEX_ID i = 0; i < size(); i++) {
-    for (LINK_ID j = 0; j < m_net[i].size(); ++j) {
-      delete m_net[i][j];
-      m_net[i].clear();
-    }
-  }
-  m_net.clear();
+// the vertices (or components) are handed out to the scan workers by chunks
+const size_t SCAN_CHUNK = 64;
 
-  if (m_reach_table) {
-    delete m_reach_table;
-  }
-}
+} // namespace
 
-void Graph::loadFromFile(const string matrix_file) {
+Graph::Graph() : m_reach_table(nullptr) {}
+
+Graph::~Graph() { release(); }
+
+void Graph::release() {
   m_vertices.clear();
   m_links.clear();
   m_edge_types.clear();
-  m_net.clear();
-  if (m_reach_table) {
-    delete m_reach_table;
+  m_multiplicity.clear();
+  m_forks.clear();
+  m_arrows.clear();
+  m_equals.clear();
+  m_arena.reset();
+}
+
+void GraphBuilder::link(VERTEX_ID source, VERTEX_ID target, LINK_ID id,
+                        EDGE_TYPE type) {
+  if (source < 0 || source >= m_degrees.size() || target < 0 ||
+      target >= m_degrees.size()) {
+    throw std::out_of_range("vertex id is too big");
+  }
+  m_degrees[source]++;
+  m_in_degrees[target]++;
+  m_links.push_back({source, target, id, type});
+}
+
+CsrGraph GraphBuilder::build() const {
+  CsrGraph csr;
+  csr.offsets.resize(m_degrees.size() + 1);
+  csr.offsets[0] = 0;
+  for (size_t v = 0; v < m_degrees.size(); ++v) {
+    csr.offsets[v + 1] = csr.offsets[v] + m_degrees[v];
+  }
+
+  csr.targets.resize(m_links.size());
+  csr.edge_ids.resize(m_links.size());
+  csr.edge_types.resize(m_links.size());
+  vector<uint32_t> next(csr.offsets.begin(), csr.offsets.end() - 1);
+  for (const Entry &e : m_links) {
+    uint32_t const i = next[e.source]++;
+    csr.targets[i] = e.target;
+    csr.edge_ids[i] = e.id;
+    csr.edge_types[i] = e.type;
   }
-  m_reach_table = nullptr;
+
+  csr.rev_offsets.resize(m_in_degrees.size() + 1);
+  csr.rev_offsets[0] = 0;
+  for (size_t v = 0; v < m_in_degrees.size(); ++v) {
+    csr.rev_offsets[v + 1] = csr.rev_offsets[v] + m_in_degrees[v];
+  }
+  csr.rev_links.resize(m_links.size());
+  csr.rev_sources.resize(m_links.size());
+  next.assign(csr.rev_offsets.begin(), csr.rev_offsets.end() - 1);
+  for (size_t v = 0; v < m_degrees.size(); ++v) {
+    for (uint32_t i = csr.offsets[v]; i < csr.offsets[v + 1]; ++i) {
+      uint32_t const k = next[csr.targets[i]]++;
+      csr.rev_links[k] = i;
+      csr.rev_sources[k] = v;
+    }
+  }
+  return csr;
+}
+
+void Graph::loadFromFile(const string &matrix_file) {
+  release();
+  m_csr = CsrGraph();
+  m_reach_table.reset();
 
   // read vertex-edge adjacency file
   // it must be m*n matrix, each element is the vertex id
@@ -61,8 +115,7 @@ void Graph::loadFromFile(const string matrix_file) {
     }
 
     rows.push_back(line);
-    m_vertices.push_back(new Vertex(m_vertices.size(), ""));
-    m_net.push_back(LinkList());
+    m_vertices.push_back(m_arena.create<Vertex>(m_vertices.size(), ""));
   }
 
   VERTEX_ID dest_v_id = 0;
@@ -115,19 +168,23 @@ void Graph::dump() {
   if (!m_links.empty()) {
     cout << "Links: " << m_links.size() << '\n';
     for (size_t i = 0; i < m_links.size(); ++i) {
-      cout << " (" << m_links[i]->from->name() << ", "
-           << m_links[i]->edge->name() << ", " << m_links[i]->to->name() << ", "
-           << m_links[i]->balance() << ")";
+      cout << " (" << m_links[i]->source.name() << ", "
+           << m_links[i]->edge.name() << ", " << m_links[i]->target.name()
+           << ", " << m_links[i]->balance() << ")";
+      if (m_multiplicity[i] > 1) {
+        cout << "x" << m_multiplicity[i];
+      }
     }
     cout << '\n';
   }
 
-  if (!m_net.empty()) {
+  if (frozen() && !m_vertices.empty()) {
     cout << "Adjacencies:" << m_links.size() << '\n';
-    for (size_t m = 0; m < m_net.size(); ++m) {
-      for (size_t i = 0; i < m_net[m].size(); ++i) {
-        cout << " " << m_net[m][i]->from->name() << "--"
-             << m_net[m][i]->edge->name() << "-->" << m_net[m][i]->to->name();
+    for (size_t m = 0; m < m_vertices.size(); ++m) {
+      for (uint32_t i = m_csr.begin(m); i < m_csr.end(m); ++i) {
+        Link *l = m_links[m_csr.edge_ids[i]];
+        cout << " " << l->source.name() << "--" << l->edge.name() << "-->"
+             << l->target.name();
       }
       cout << '\n';
     }
@@ -157,7 +214,7 @@ void Graph::dump() {
 
 Link *Graph::link(VERTEX_ID source, VERTEX_ID target, EDGE_TYPE type) {
   if (m_edge_types.size() == type) {
-    m_edge_types.push_back(new GraphElement(type, ""));
+    m_edge_types.push_back(m_arena.create<GraphElement>(type, ""));
   }
 
   if (source >= size() || target >= size()) {
@@ -172,28 +229,22 @@ Link *Graph::link(VERTEX_ID source, VERTEX_ID target, EDGE_TYPE type) {
   }
   */
 
-  Edge *edge = new Edge(m_links.size(), "", type);
-  Link *link = new Link(m_vertices[source], m_vertices[target], edge);
+  Edge *edge = m_arena.create<Edge>(m_links.size(), "", type);
+  Link *link =
+      m_arena.create<Link>(*m_vertices[source], *m_vertices[target], *edge);
   m_links.push_back(link);
-  m_net[source].push_back(link);
+  m_multiplicity.push_back(1);
   m_vertices[source]->out_degree++;
   m_vertices[target]->in_degree++;
   return link;
-  // m_net[v1].push_back(m_links.back());
 }
 
 const bool Graph::good() const {
-  if (m_vertices.size() != m_net.size()) {
-    return false;
-  }
-
-  for (VERTEX_ID i = 0; i < m_vertices.size(); ++i) {
-    for (size_t j = 0; j < m_net[i].size(); ++j) {
-      if (m_net[i][j]->edge->type >= m_edge_types.size() ||
-          m_net[i][j]->from->id >= m_vertices.size() ||
-          m_net[i][j]->to->id >= m_vertices.size()) {
-        return false;
-      }
+  for (Link *l : m_links) {
+    if (l->edge.type >= m_edge_types.size() ||
+        l->source.id >= m_vertices.size() ||
+        l->target.id >= m_vertices.size()) {
+      return false;
     }
   }
 
@@ -202,46 +253,149 @@ const bool Graph::good() const {
 
 void Graph::eulerize() {
   // try to make all the vertices balance, e.g. in_degree == out_degree
-  // divide the graph vertices into 2 parts,
-  // the vertices in one partition are all in_degree > out_degree
-  // and the other partition includes vertices in_degress < out_degree
+  // an arrow vertex (in_degree > out_degree) needs balance() more walks out
+  // of it, and a fork vertex (in_degree < out_degree) -balance() more walks
+  // into it, each made by repeating a path from an arrow to a fork
+  // the repeated paths are chosen all at once as a transportation problem,
+  // a unit from an arrow to a fork costing the length of the shortest path
+  // between them, so the Euler cycle is as short as possible
   // the balanced vertices are ignored
-  vector<LinkList *> bridges;
-  do {
-    divide();
+  divide();
+  if (m_arrows.empty()) {
+    dump();
+    return;
+  }
 
-    bridges.clear();
-    for (auto const &arrow : m_arrows) {
-      for (auto const &fork : m_forks) {
-        LinkList *bridge =
-            GraphTravellerBfs::shortestPath(*this, *arrow, *fork);
-        if (bridge) {
-          bridges.push_back(bridge);
-        }
-      }
+  const size_t none = static_cast<size_t>(-1);
+  vector<uint32_t> supply;
+  vector<uint32_t> demand;
+  vector<VERTEX_ID> arrows;
+  vector<size_t> fork_index(m_vertices.size(), none);
+  for (Vertex *arrow : m_arrows) {
+    arrows.push_back(arrow->id);
+    supply.push_back(arrow->balance());
+  }
+  for (Vertex *fork : m_forks) {
+    fork_index[fork->id] = demand.size();
+    demand.push_back(-fork->balance());
+  }
+
+  // the distances from the arrows to the forks, 64 BFS at once
+  vector<vector<uint32_t>> cost(
+      arrows.size(),
+      vector<uint32_t>(demand.size(), Transportation::NO_ROUTE));
+  MultiSourceBfs bfs(*this);
+  for (size_t first = 0; first < arrows.size();
+       first += MultiSourceBfs::MAX_SOURCES) {
+    size_t const count =
+        min(MultiSourceBfs::MAX_SOURCES, arrows.size() - first);
+    bfs.run(&arrows[first], count,
+            [&cost, &fork_index, first, none](
+                VERTEX_ID v, MultiSourceBfs::LANES lanes, size_t depth) {
+              if (fork_index[v] == none) {
+                return;
+              }
+              for (; lanes != 0; lanes &= lanes - 1) {
+                cost[first + __builtin_ctzll(lanes)][fork_index[v]] = depth;
+              }
+            });
+  }
+
+  Transportation transport(supply, demand, cost);
+  transport.solve();
+
+  // repeat a shortest path from every arrow to the forks it sends to
+  vector<uint32_t> parent;
+  vector<VERTEX_ID> queue;
+  LinkList path;
+  for (size_t i = 0; i < arrows.size(); ++i) {
+    const vector<uint32_t> &flow = transport.flow()[i];
+    if (all_of(flow.begin(), flow.end(),
+               [](uint32_t units) { return units == 0; })) {
+      continue;
     }
 
-    std::sort(bridges.begin(), bridges.end(), Graph::compareByLength);
-    for (vector<LinkList *>::const_iterator bridge = bridges.begin();
-         bridge != bridges.end(); ++bridge) {
-      Link *left = (*bridge)->front();
-      Link *right = (*bridge)->back();
-      while (left->source->balance() > 0 && right->target->balance() < 0) {
-        clonePath(**bridge);
+    shortestPaths(arrows[i], parent, queue);
+    for (Vertex *fork : m_forks) {
+      uint32_t const units = flow[fork_index[fork->id]];
+      if (units == 0) {
+        continue;
       }
+      path.clear();
+      for (VERTEX_ID v = fork->id; v != arrows[i];) {
+        Link *l = m_links[m_csr.edge_ids[parent[v]]];
+        path.push_back(l);
+        v = l->source.id;
+      }
+      reverse(path.begin(), path.end());
+      repeatPath(path, units);
     }
-    // dump();
-  } while (!bridges.empty());
+  }
+
+  divide();
   dump();
 }
 
+void Graph::shortestPaths(VERTEX_ID v, vector<uint32_t> &parent,
+                          vector<VERTEX_ID> &queue) const {
+  const CsrGraph &g = csr();
+  parent.assign(m_vertices.size(), NO_PARENT);
+  queue.clear();
+  queue.push_back(v);
+  for (size_t head = 0; head < queue.size(); ++head) {
+    VERTEX_ID const w = queue[head];
+    for (uint32_t i = g.begin(w); i < g.end(w); ++i) {
+      VERTEX_ID const x = g.targets[i];
+      if (x == v || parent[x] != NO_PARENT) {
+        continue;
+      }
+      parent[x] = i;
+      queue.push_back(x);
+    }
+  }
+}
+
+void Graph::distancesTo(VERTEX_ID v, vector<uint32_t> &distance) const {
+  const CsrGraph &g = csr();
+  distance.assign(m_vertices.size(), NO_DISTANCE);
+  vector<VERTEX_ID> queue(1, v);
+  distance[v] = 0;
+  for (size_t head = 0; head < queue.size(); ++head) {
+    VERTEX_ID const w = queue[head];
+    for (uint32_t k = g.rbegin(w); k < g.rend(w); ++k) {
+      VERTEX_ID const x = g.rev_sources[k];
+      if (distance[x] == NO_DISTANCE) {
+        distance[x] = distance[w] + 1;
+        queue.push_back(x);
+      }
+    }
+  }
+}
+
 const size_t Graph::size() const { return m_vertices.size(); }
 
-const LinkList &Graph::getAdjacencies(const VERTEX_ID v_id) const {
-  if (v_id >= m_net.size()) {
+Adjacencies Graph::getAdjacencies(const VERTEX_ID v_id) const {
+  if (v_id >= m_vertices.size()) {
     throw std::out_of_range("vertex id is too big");
   }
-  return m_net[v_id];
+  const CsrGraph &g = csr();
+  return Adjacencies(m_links, g.edge_ids.data() + g.begin(v_id),
+                     g.edge_ids.data() + g.end(v_id));
+}
+
+void Graph::freeze() {
+  GraphBuilder builder(m_vertices.size());
+  for (Link *l : m_links) {
+    builder.link(l->source.id, l->target.id, l->edge.id, l->edge.type);
+  }
+  m_csr = builder.build();
+}
+
+const CsrGraph &Graph::csr() const {
+  if (!frozen()) {
+    throw std::logic_error("graph is not frozen");
+  }
+  return m_csr;
 }
 
 void Graph::scan() {
@@ -250,34 +404,355 @@ void Graph::scan() {
   // each bit represent connectivity of node (i->j)
   // set initial value to 0
 
-  m_reach_table = new BitMap2(m_vertices.size(), m_vertices.size());
-  BitMap *visit_table = new BitMap(m_vertices.size());
+  freeze();
+  components();
+
+  m_reach_rows.resize(m_vertices.size());
+  if (m_scan_method == SCAN_SCC) {
+    for (VERTEX_ID v = 0; v < m_vertices.size(); ++v) {
+      m_reach_rows[v] = m_scc[v];
+    }
+    scanComponents();
+    divide();
+    return;
+  }
+
   for (VERTEX_ID v = 0; v < m_vertices.size(); ++v) {
-    visit_table->reset();
+    m_reach_rows[v] = v;
+  }
+  if (m_scan_method == SCAN_MSBFS) {
+    scanMultiSource();
+    divide();
+    return;
+  }
+  // every worker claims chunks of source vertices and runs their BFS with
+  // its own frontier, the workers write disjoint rows of the table
+  atomic<size_t> next(0);
+  size_t const n = m_vertices.size();
+  if (m_reach_policy == RP_SPARSE) {
+    std::shared_ptr<RoaringBitMap2> table =
+        std::make_shared<RoaringBitMap2>(n, n);
+    runWorkers(workers(n), [this, &table, &next, n]() {
+      BitMap visit(n);
+      vector<VERTEX_ID> frontier;
+      for (size_t first = next.fetch_add(SCAN_CHUNK); first < n;
+           first = next.fetch_add(SCAN_CHUNK)) {
+        for (size_t v = first; v < min(n, first + SCAN_CHUNK); ++v) {
+          // BFS on a dense visit table, then compress it into the row
+          visit.reset();
+          reach(v, visit.view(), frontier);
+          table->row(v).assign(visit);
+        }
+      }
+    });
+    m_reach_table = table;
+  } else if (m_scan_method == SCAN_CLOSURE) {
+    std::shared_ptr<BitMap2> table = std::make_shared<BitMap2>(n, n);
+    for (LinkList::const_iterator it = m_links.begin(); it != m_links.end();
+         ++it) {
+      table->set((*it)->source.id, (*it)->target.id);
+    }
+    BitMatrixClosure::fourRussians(*table);
+    m_reach_table = table;
+  } else {
+    std::shared_ptr<BitMap2> table = std::make_shared<BitMap2>(n, n);
+    runWorkers(workers(n), [this, &table, &next, n]() {
+      vector<VERTEX_ID> frontier;
+      for (size_t first = next.fetch_add(SCAN_CHUNK); first < n;
+           first = next.fetch_add(SCAN_CHUNK)) {
+        for (size_t v = first; v < min(n, first + SCAN_CHUNK); ++v) {
+          // the vertices visited by the BFS from v are exactly the vertices
+          // reachable from v, so the row of v is used as the visit table
+          reach(v, table->row(v), frontier);
+        }
+      }
+    });
+    m_reach_table = table;
+  }
+
+  divide();
+}
 
-    queue<VERTEX_ID> q;
-    q.push(v);
-    visit_table->reset();
-    // m_reach_table->set(v, v);
+void Graph::scanMultiSource() {
+  size_t const n = m_vertices.size();
+  size_t const lanes = MultiSourceBfs::MAX_SOURCES;
+  std::shared_ptr<BitMap2> dense;
+  std::shared_ptr<RoaringBitMap2> sparse;
+  if (m_reach_policy == RP_SPARSE) {
+    sparse = std::make_shared<RoaringBitMap2>(n, n);
+  } else {
+    dense = std::make_shared<BitMap2>(n, n);
+  }
 
-    while (!q.empty()) {
-      VERTEX_ID const w = q.front();
-      q.pop();
+  // every worker claims batches of 64 consecutive source vertices
+  atomic<size_t> next(0);
+  runWorkers(workers(n), [this, &dense, &sparse, &next, n, lanes]() {
+    MultiSourceBfs bfs(*this);
+    vector<VERTEX_ID> sources;
+    // the rows of a batch for the sparse table, compressed at the end
+    vector<BitMap> rows;
+    if (sparse) {
+      rows.assign(lanes, BitMap(n));
+    }
 
-      for (LinkList::iterator it = m_net[w].begin(); it != m_net[w].end();
-           ++it) {
-        VERTEX_ID const x = (*it)->to->id;
-        if (visit_table->get(x) == 1) {
-          continue;
+    for (size_t first = next.fetch_add(lanes); first < n;
+         first = next.fetch_add(lanes)) {
+      sources.clear();
+      for (size_t v = first; v < min(n, first + lanes); ++v) {
+        sources.push_back(v);
+      }
+      for (BitMap &row : rows) {
+        row.reset();
+      }
+
+      bfs.run(
+          sources.data(), sources.size(),
+          [&dense, &rows, first](VERTEX_ID w, MultiSourceBfs::LANES bits,
+                                 size_t) {
+            for (; bits != 0; bits &= bits - 1) {
+              size_t const i = __builtin_ctzll(bits);
+              if (dense) {
+                dense->set(first + i, w);
+              } else {
+                rows[i].set(w);
+              }
+            }
+          },
+          false);
+
+      if (sparse) {
+        for (size_t i = 0; i < sources.size(); ++i) {
+          sparse->row(first + i).assign(rows[i]);
         }
-        visit_table->set(x);
-        m_reach_table->set(v, x);
-        q.push(x);
       }
     }
+  });
+
+  if (dense) {
+    m_reach_table = dense;
+  } else {
+    m_reach_table = sparse;
   }
+}
 
-  divide();
+void Graph::components() {
+  const size_t n = m_vertices.size();
+  const size_t none = static_cast<size_t>(-1);
+
+  // Tarjan with an explicit call stack, a frame is a vertex and the next
+  // adjacent link to explore, as an index in the CSR arrays
+  vector<size_t> index(n, none);
+  vector<size_t> low(n);
+  vector<bool> on_stack(n, false);
+  vector<VERTEX_ID> stack;
+  vector<pair<VERTEX_ID, size_t>> frames;
+  size_t counter = 0;
+  size_t count = 0;
+
+  m_scc.assign(n, none);
+  for (VERTEX_ID root = 0; root < n; ++root) {
+    if (index[root] != none) {
+      continue;
+    }
+
+    index[root] = low[root] = counter++;
+    stack.push_back(root);
+    on_stack[root] = true;
+    frames.emplace_back(root, m_csr.begin(root));
+    while (!frames.empty()) {
+      VERTEX_ID const v = frames.back().first;
+      size_t &next = frames.back().second;
+
+      if (next < m_csr.end(v)) {
+        VERTEX_ID const w = m_csr.targets[next++];
+        if (index[w] == none) {
+          index[w] = low[w] = counter++;
+          stack.push_back(w);
+          on_stack[w] = true;
+          frames.emplace_back(w, m_csr.begin(w));
+        } else if (on_stack[w]) {
+          low[v] = min(low[v], index[w]);
+        }
+        continue;
+      }
+
+      // all the links of v explored, v is the root of a component if no
+      // vertex on the stack is reached from the subtree of v
+      if (low[v] == index[v]) {
+        VERTEX_ID w;
+        do {
+          w = stack.back();
+          stack.pop_back();
+          on_stack[w] = false;
+          m_scc[w] = count;
+        } while (w != v);
+        ++count;
+      }
+      frames.pop_back();
+      if (!frames.empty()) {
+        VERTEX_ID const u = frames.back().first;
+        low[u] = min(low[u], low[v]);
+      }
+    }
+  }
+
+  m_scc_members.assign(count, vector<VERTEX_ID>());
+  for (VERTEX_ID v = 0; v < n; ++v) {
+    m_scc_members[m_scc[v]].push_back(v);
+  }
+
+  // the condensation, without duplicated edges
+  m_scc_dag.assign(count, vector<size_t>());
+  vector<size_t> seen(count, none);
+  for (size_t c = 0; c < count; ++c) {
+    for (VERTEX_ID const v : m_scc_members[c]) {
+      for (uint32_t i = m_csr.begin(v); i < m_csr.end(v); ++i) {
+        size_t const to = m_scc[m_csr.targets[i]];
+        if (to != c && seen[to] != c) {
+          seen[to] = c;
+          m_scc_dag[c].push_back(to);
+        }
+      }
+    }
+  }
+}
+
+void Graph::scanComponents() {
+  const size_t n = m_vertices.size();
+  const size_t count = sccCount();
+
+  // the successors of a component have lower ids, so their rows are complete
+  // when the component is reached
+  // a component reaches
+  //   its own vertices if it has an internal link (a cycle)
+  //   the targets of its outgoing links
+  //   everything reached by the components of these targets
+  std::shared_ptr<BitMap2> dense;
+  std::shared_ptr<RoaringBitMap2> sparse;
+  if (m_reach_policy == RP_SPARSE) {
+    sparse = std::make_shared<RoaringBitMap2>(count, n);
+  } else {
+    dense = std::make_shared<BitMap2>(count, n);
+  }
+
+  auto fill = [this, &dense, &sparse](const size_t c) {
+    bool cycle = false;
+    for (VERTEX_ID const v : m_scc_members[c]) {
+      for (uint32_t i = m_csr.begin(v); i < m_csr.end(v); ++i) {
+        VERTEX_ID const w = m_csr.targets[i];
+        if (m_scc[w] == c) {
+          cycle = true;
+        } else if (dense) {
+          dense->set(c, w);
+        } else {
+          sparse->set(c, w);
+        }
+      }
+    }
+    if (cycle) {
+      for (VERTEX_ID const v : m_scc_members[c]) {
+        if (dense) {
+          dense->set(c, v);
+        } else {
+          sparse->set(c, v);
+        }
+      }
+    }
+
+    for (size_t const to : m_scc_dag[c]) {
+      if (dense) {
+        dense->row(c) |= dense->row(to);
+      } else {
+        sparse->row(c) |= (*sparse)[to];
+      }
+    }
+    if (sparse) {
+      sparse->row(c).optimize();
+    }
+  };
+
+  // the components of one level only depend on the lower levels, so a level
+  // is filled by all the workers at once
+  // level of c = 1 + the highest level of its successors
+  vector<size_t> level(count, 0);
+  size_t levels = 0;
+  for (size_t c = 0; c < count; ++c) {
+    for (size_t const to : m_scc_dag[c]) {
+      level[c] = max(level[c], level[to] + 1);
+    }
+    levels = max(levels, level[c] + 1);
+  }
+  vector<vector<size_t>> by_level(levels);
+  for (size_t c = 0; c < count; ++c) {
+    by_level[level[c]].push_back(c);
+  }
+
+  for (const vector<size_t> &components : by_level) {
+    atomic<size_t> next(0);
+    runWorkers(workers(components.size()), [&components, &next, &fill]() {
+      for (size_t first = next.fetch_add(SCAN_CHUNK);
+           first < components.size(); first = next.fetch_add(SCAN_CHUNK)) {
+        for (size_t i = first; i < min(components.size(), first + SCAN_CHUNK);
+             ++i) {
+          fill(components[i]);
+        }
+      }
+    });
+  }
+
+  if (dense) {
+    m_reach_table = dense;
+  } else {
+    m_reach_table = sparse;
+  }
+}
+
+void Graph::setReachPolicy(REACH_POLICY policy) {
+  if (policy == m_reach_policy) {
+    return;
+  }
+  m_reach_policy = policy;
+  if (m_reach_table != nullptr) {
+    scan();
+  }
+}
+
+void Graph::setScanMethod(SCAN_METHOD method) {
+  if (method == m_scan_method) {
+    return;
+  }
+  m_scan_method = method;
+  if (m_reach_table != nullptr) {
+    scan();
+  }
+}
+
+void Graph::reach(VERTEX_ID v, MutableBitMapView const &visit,
+                  vector<VERTEX_ID> &frontier) const {
+  // the frontier is used as the BFS queue
+  frontier.clear();
+  frontier.push_back(v);
+
+  for (size_t head = 0; head < frontier.size(); ++head) {
+    VERTEX_ID const w = frontier[head];
+    for (uint32_t i = m_csr.begin(w); i < m_csr.end(w); ++i) {
+      VERTEX_ID const x = m_csr.targets[i];
+      if (visit.get(x)) {
+        continue;
+      }
+      visit.set(x);
+      frontier.push_back(x);
+    }
+  }
+}
+
+size_t Graph::workers(const size_t tasks) const {
+  size_t threads = m_scan_threads;
+  if (threads == 0) {
+    threads = max(1u, thread::hardware_concurrency());
+  }
+  // no thread for less than a chunk of tasks
+  return max<size_t>(1, min(threads, tasks / SCAN_CHUNK));
 }
 
 void Graph::divide() {
@@ -1,12 +1,15 @@
 #ifndef CASEGEN_GRAPH_H
 #define CASEGEN_GRAPH_H
 
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
 #include <map>
 #include <memory>
-#include <sstream>
 #include <string>
 #include <vector>
 
+#include "arena.h"
 #include "bitmap.h"
 
 #define ELEMENT_ID int
@@ -21,6 +24,7 @@ struct GraphElement {
 
   GraphElement(ELEMENT_ID _id, const std::string &_content)
       : id(_id), content(_content){};
+  virtual ~GraphElement() = default;
 
   virtual std::string name() { return content; };
 };
@@ -30,14 +34,12 @@ struct Vertex : public GraphElement {
   int in_degree{0};
   int out_degree{0};
 
-  Vertex(const ELEMENT_ID _id, const string &_content)
+  Vertex(const ELEMENT_ID _id, const std::string &_content)
       : GraphElement(_id, _content){};
 
   std::string name() override {
     if (content.empty()) {
-      std::stringstream oss;
-      oss << "S" << id;
-      content = oss.str();
+      content = "S" + std::to_string(id);
     }
     return content;
   };
@@ -53,9 +55,7 @@ struct Edge : public GraphElement {
 
   std::string name() override {
     if (content.empty()) {
-      std::stringstream oss;
-      oss << "E" << type;
-      content = oss.str();
+      content = "E" + std::to_string(type);
     }
     return content;
   };
@@ -63,11 +63,11 @@ struct Edge : public GraphElement {
 
 // tuple for link
 struct Link {
-  const Vertex &source;
-  const Vertex &target;
-  const Edge &edge;
+  Vertex &source;
+  Vertex &target;
+  Edge &edge;
 
-  Link(const Vertex &v1, const Vertex &v2, const Edge &e)
+  Link(Vertex &v1, Vertex &v2, Edge &e)
       : source(v1), target(v2), edge(e){};
 
   bool circle() const { return (source.id == target.id); };
@@ -79,7 +79,114 @@ typedef std::vector<GraphElement *> EdgeList;
 typedef std::vector<Vertex *> VertexList;
 typedef std::vector<Link *> LinkList;
 
-typedef std::vector<LinkList> Net;
+// frozen graph in compressed sparse row form
+// the links of vertex v are [offsets[v], offsets[v + 1]) of the link arrays,
+// in the order they were linked, edge_ids[i] is the id of the Link (and Edge)
+// the reverse index lists the links entering v, as positions in the link
+// arrays, in [rev_offsets[v], rev_offsets[v + 1]) of rev_links, and their
+// sources in rev_sources
+class CsrGraph {
+public:
+  std::vector<uint32_t> offsets;
+  std::vector<VERTEX_ID> targets;
+  std::vector<LINK_ID> edge_ids;
+  std::vector<EDGE_TYPE> edge_types;
+  std::vector<uint32_t> rev_offsets;
+  std::vector<uint32_t> rev_links;
+  std::vector<VERTEX_ID> rev_sources;
+
+  size_t vertices() const { return offsets.empty() ? 0 : offsets.size() - 1; };
+  size_t links() const { return targets.size(); };
+  uint32_t begin(const VERTEX_ID v) const { return offsets[v]; };
+  uint32_t end(const VERTEX_ID v) const { return offsets[v + 1]; };
+  uint32_t degree(const VERTEX_ID v) const { return end(v) - begin(v); };
+  uint32_t rbegin(const VERTEX_ID v) const { return rev_offsets[v]; };
+  uint32_t rend(const VERTEX_ID v) const { return rev_offsets[v + 1]; };
+
+  // bytes of the arrays
+  size_t memory() const {
+    return (offsets.size() + rev_offsets.size()) * sizeof(uint32_t) +
+           links() * (2 * sizeof(VERTEX_ID) + sizeof(LINK_ID) +
+                      sizeof(EDGE_TYPE) + sizeof(uint32_t));
+  };
+};
+
+// collects the links of a graph and freezes them into a CsrGraph
+class GraphBuilder {
+public:
+  explicit GraphBuilder(size_t vertices)
+      : m_degrees(vertices, 0), m_in_degrees(vertices, 0){};
+
+  void link(VERTEX_ID source, VERTEX_ID target, LINK_ID id, EDGE_TYPE type);
+  // counting sort of the links by source, the links of a vertex keep the
+  // order they were added in, then by target for the reverse index
+  CsrGraph build() const;
+
+private:
+  struct Entry {
+    VERTEX_ID source;
+    VERTEX_ID target;
+    LINK_ID id;
+    EDGE_TYPE type;
+  };
+
+  std::vector<uint32_t> m_degrees;
+  std::vector<uint32_t> m_in_degrees;
+  std::vector<Entry> m_links;
+};
+
+// the links of a vertex as Link objects, a view on the frozen graph kept for
+// the callers of Graph::getAdjacencies
+class Adjacencies {
+public:
+  class const_iterator {
+  public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef Link *value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef Link *const *pointer;
+    typedef Link *reference;
+
+    const_iterator(const LinkList &links, const LINK_ID *id)
+        : m_links(&links), m_id(id){};
+
+    Link *operator*() const { return (*m_links)[*m_id]; };
+    const_iterator &operator++() {
+      ++m_id;
+      return *this;
+    };
+    const_iterator operator++(int) {
+      const_iterator const it = *this;
+      ++m_id;
+      return it;
+    };
+    bool operator==(const const_iterator &rhs) const {
+      return m_id == rhs.m_id;
+    };
+    bool operator!=(const const_iterator &rhs) const {
+      return m_id != rhs.m_id;
+    };
+
+  private:
+    const LinkList *m_links;
+    const LINK_ID *m_id;
+  };
+
+  Adjacencies(const LinkList &links, const LINK_ID *first,
+              const LINK_ID *last)
+      : m_links(links), m_first(first), m_last(last){};
+
+  const_iterator begin() const { return const_iterator(m_links, m_first); };
+  const_iterator end() const { return const_iterator(m_links, m_last); };
+  size_t size() const { return m_last - m_first; };
+  bool empty() const { return m_first == m_last; };
+  Link *operator[](const size_t i) const { return m_links[m_first[i]]; };
+
+private:
+  const LinkList &m_links;
+  const LINK_ID *m_first;
+  const LINK_ID *m_last;
+};
 
 // graph
 class Graph {
@@ -90,17 +197,16 @@ public:
   virtual void loadFromFile(const std::string &matrix_file);
 
   virtual void init(size_t rows) {
-    m_vertices.clear();
-    m_links.clear();
-    m_edge_types.clear();
-    m_net.clear();
-    if (m_reach_table) {
-      delete m_reach_table;
-    }
+    release();
+    m_csr = CsrGraph();
+    m_reach_table.reset();
+    m_reach_rows.clear();
+    m_scc.clear();
+    m_scc_members.clear();
+    m_scc_dag.clear();
 
     for (size_t i = 0; i < rows; ++i) {
-      m_vertices.push_back(new Vertex(m_vertices.size(), ""));
-      m_net.push_back(LinkList());
+      m_vertices.push_back(m_arena.create<Vertex>(m_vertices.size(), ""));
     }
   }
 
@@ -110,30 +216,113 @@ public:
   virtual const size_t size() const;
 
   virtual bool reachable(const VERTEX_ID v1, const VERTEX_ID v2) const {
-    return m_reach_table->get(v1, v2);
+    return m_reach_table->get(m_reach_rows[v1], v2);
   }
 
+  // storage of the reachable table
+  enum REACH_POLICY {
+    RP_DENSE = 0, // BitMap2, V * V bits
+    RP_SPARSE     // RoaringBitMap2, compressed rows for big sparse graphs
+  };
+  // a scanned graph is scanned again if the policy changes
+  void setReachPolicy(REACH_POLICY policy);
+  REACH_POLICY reachPolicy() const { return m_reach_policy; };
+  const IBitMap2 *reachTable() const { return m_reach_table.get(); };
+  // the row of the reachable table holding the vertices reachable from v,
+  // the vertices of a strongly connected component may share one row
+  size_t reachRow(const VERTEX_ID v) const { return m_reach_rows[v]; };
+
+  // how scan fills the reachable table
+  enum SCAN_METHOD {
+    SCAN_BFS = 0, // one BFS per vertex
+    SCAN_CLOSURE, // transitive closure of the adjacency bit matrix, dense only
+    SCAN_SCC,     // one row per strongly connected component, propagated on
+                  // the condensation
+    SCAN_MSBFS    // 64 BFS at once, bit-parallel
+  };
+  // a scanned graph is scanned again if the method changes
+  void setScanMethod(SCAN_METHOD method);
+  SCAN_METHOD scanMethod() const { return m_scan_method; };
+  // number of threads used by scan, 0 for all the cores of the machine
+  // the table is the same whatever the number of threads
+  void setScanThreads(const size_t threads) { m_scan_threads = threads; };
+  size_t scanThreads() const { return m_scan_threads; };
+
+  // strongly connected components, computed by scan
+  // the ids are in reverse topological order of the condensation, an edge
+  // between 2 components always goes from the higher id to the lower one
+  size_t sccCount() const { return m_scc_dag.size(); };
+  size_t sccId(const VERTEX_ID v) const { return m_scc[v]; };
+  // the components reached by one edge from component c in the condensation
+  const std::vector<size_t> &sccSuccessors(const size_t c) const {
+    return m_scc_dag[c];
+  };
+  const std::vector<VERTEX_ID> &sccMembers(const size_t c) const {
+    return m_scc_members[c];
+  };
+
   const VertexList &getVertices() const { return m_vertices; };
   Vertex *getVertex(const VERTEX_ID v) const { return m_vertices[v]; };
   const LinkList &getLinks() const { return m_links; };
   Link *getLink(const LINK_ID e) const { return m_links[e]; };
-  const virtual LinkList &getAdjacencies(const VERTEX_ID v_id) const;
-
+  // the links leaving v_id, the graph must be frozen
+  virtual Adjacencies getAdjacencies(const VERTEX_ID v_id) const;
+
+  // build the CSR arrays from the links, scan freezes the graph, a link
+  // added later needs a new freeze before the graph is travelled
+  void freeze();
+  bool frozen() const {
+    return m_csr.vertices() == m_vertices.size() &&
+           m_csr.links() == m_links.size();
+  };
+  // the frozen graph, throws logic_error if links were added since the freeze
+  const CsrGraph &csr() const;
+
+  // hops from every vertex to v on the reverse index, NO_DISTANCE if v is
+  // out of reach, the graph must be frozen
+  static constexpr uint32_t NO_DISTANCE = static_cast<uint32_t>(-1);
+  void distancesTo(VERTEX_ID v, std::vector<uint32_t> &distance) const;
+
+  // balance the graph by walking some links several times, no link is added
+  // the in and out degrees of the vertices count the walks
+  // the extra walks are the fewest possible (directed Chinese postman), the
+  // graph must be frozen
   virtual void eulerize();
   bool eulerian() const;
+  // times the link e is walked by an Euler cycle, 1 before eulerize
+  uint32_t multiplicity(const LINK_ID e) const { return m_multiplicity[e]; };
+  const std::vector<uint32_t> &multiplicities() const {
+    return m_multiplicity;
+  };
 
   void scan();
   virtual void dump();
 
 private:
-  Net m_net;
+  // every Vertex, Edge, Link and edge type of the graph, released at once
+  Arena m_arena;
+  CsrGraph m_csr;
 
   VertexList m_vertices;
   LinkList m_links;
   EdgeList m_edge_types;
+  // link -> multiplicity
+  std::vector<uint32_t> m_multiplicity;
 
   // a 2D bit map saving the reachable info of 2 vertices
-  std::shared_ptr<BitMap2> m_reach_table;
+  std::shared_ptr<IBitMap2> m_reach_table;
+  REACH_POLICY m_reach_policy{RP_DENSE};
+  SCAN_METHOD m_scan_method{SCAN_SCC};
+  size_t m_scan_threads{0};
+  // vertex -> row of the reachable table
+  std::vector<size_t> m_reach_rows;
+
+  // vertex -> strongly connected component
+  std::vector<size_t> m_scc;
+  // component -> vertices
+  std::vector<std::vector<VERTEX_ID>> m_scc_members;
+  // the condensation, component -> successor components
+  std::vector<std::vector<size_t>> m_scc_dag;
 
   VertexList m_forks; // the vertices set which all the vertices' in degree less
                       // than out degress
@@ -142,34 +331,51 @@ private:
   VertexList m_equals; // the vertices set which all the vertices' in degree
                        // equals to out degress
 
+  // BFS from v, mark all the vertices reachable from v in visit, frontier is
+  // the scratch queue of the caller
+  void reach(VERTEX_ID v, MutableBitMapView const &visit,
+             std::vector<VERTEX_ID> &frontier) const;
+  // number of scan workers for tasks independent tasks
+  size_t workers(const size_t tasks) const;
+
+  // iterative Tarjan, fill m_scc and m_scc_dag
+  void components();
+  // one reachable row per component, in the order of the component ids
+  void scanComponents();
+  // one reachable row per vertex, by batches of multi-source BFS
+  void scanMultiSource();
+
+  // drop all the vertices and links, and the memory of the arena
+  void release();
+
   void divide(); // divide the vertices into 2 parts, fork vertices and arrow
                  // vertices
 
-  // clonePath, duplicate every edge in the path
+  // repeatPath, walk every edge in the path once more
   // this is the function to be used for graph eulerization
-  // to add directed edges between vertices a and b
+  // to add directed walks between vertices a and b
   // which a is arrow vertex and be is fork vertex
   // a and be might be directed connected or intermedia connected through
   // multipl balanced vertices this function is to increase out degree of a and
-  // in degree of b by repeating cloning the path in limited times either a or b
+  // in degree of b by repeating the path in limited times either a or b
   // will become balanced vertex (or both get to balance at same time) because
-  // we will add both in edge and out edge at same time on the intermedia vertex
+  // we will add both in walk and out walk at same time on the intermedia vertex
   // if a and b are not directly connected, so the operation will not break the
   // balance status of the intermedia vertices
-  void clonePath(const LinkList &path) {
+  void repeatPath(const LinkList &path, const uint32_t times = 1) {
     for (size_t i = 0; i < path.size(); ++i) {
       Link *l = path[i];
-      link(l->source->id, l->target->id, l->edge->type);
+      m_multiplicity[l->edge.id] += times;
+      l->source.out_degree += times;
+      l->target.in_degree += times;
     }
   }
 
-  inline static bool compareByLength(const LinkList *path1,
-                                     const LinkList *path2) {
-    if (nullptr == path1 || nullptr == path2) {
-      throw std::runtime_error("null pointer");
-    }
-    return (path1->size() < path2->size());
-  }
+  // BFS tree from v, parent[w] is the position in the CSR arrays of the link
+  // reaching w, NO_PARENT if w is not reached, queue is scratch space
+  static constexpr uint32_t NO_PARENT = static_cast<uint32_t>(-1);
+  void shortestPaths(VERTEX_ID v, std::vector<uint32_t> &parent,
+                     std::vector<VERTEX_ID> &queue) const;
 };
 
 #endif
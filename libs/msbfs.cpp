@@ -0,0 +1,38 @@
+#include <algorithm>
+#include <vector>
+
+#include "msbfs.h"
+
+using namespace std;
+
+void MultiSourceBfs::distances(const vector<VERTEX_ID> &sources,
+                               vector<vector<uint32_t>> &distances) {
+  distances.assign(sources.size(), vector<uint32_t>(m_csr.vertices(),
+                                                    UNREACHABLE));
+  for (size_t first = 0; first < sources.size(); first += MAX_SOURCES) {
+    size_t const count = min(MAX_SOURCES, sources.size() - first);
+    run(&sources[first], count,
+        [&distances, first](VERTEX_ID v, LANES lanes, size_t depth) {
+          for (; lanes != 0; lanes &= lanes - 1) {
+            distances[first + __builtin_ctzll(lanes)][v] = depth;
+          }
+        });
+  }
+}
+
+vector<uint32_t>
+MultiSourceBfs::eccentricity(const vector<VERTEX_ID> &sources) {
+  vector<uint32_t> eccentricity(sources.size(), 0);
+  for (size_t first = 0; first < sources.size(); first += MAX_SOURCES) {
+    size_t const count = min(MAX_SOURCES, sources.size() - first);
+    // the levels come in order, the last level reached by a source is its
+    // eccentricity
+    run(&sources[first], count,
+        [&eccentricity, first](VERTEX_ID, LANES lanes, size_t depth) {
+          for (; lanes != 0; lanes &= lanes - 1) {
+            eccentricity[first + __builtin_ctzll(lanes)] = depth;
+          }
+        });
+  }
+  return eccentricity;
+}
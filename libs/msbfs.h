@@ -0,0 +1,105 @@
+#ifndef CASEGEN_MSBFS_H_
+#define CASEGEN_MSBFS_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "graph.h"
+
+// multi-source BFS, runs the BFS of up to 64 sources at once
+// every vertex has one word for the sources which have seen it, one for the
+// frontier and one for the next frontier, bit i of a word being the BFS of
+// the i-th source, so each adjacency list is read once per level for all the
+// sources
+class MultiSourceBfs {
+public:
+  typedef uint64_t LANES;
+  static constexpr size_t MAX_SOURCES = 64;
+  // distance of the vertices not reachable
+  static constexpr uint32_t UNREACHABLE = static_cast<uint32_t>(-1);
+
+  // the graph must be frozen
+  explicit MultiSourceBfs(const Graph &g)
+      : m_csr(g.csr()), m_seen(g.size(), 0), m_frontier(g.size(), 0),
+        m_next(g.size(), 0){};
+
+  // BFS from sources[0, count), count <= MAX_SOURCES
+  // visit(v, lanes, depth) is called once per level for every vertex newly
+  // reached at depth by the sources in lanes
+  // with include_sources the sources are seen at depth 0, otherwise a source
+  // is only visited if it is on a cycle, as the reachable table of Graph
+  template <typename VISIT>
+  void run(const VERTEX_ID *sources, const size_t count, VISIT visit,
+           const bool include_sources = true);
+
+  // the distances from each source to every vertex, UNREACHABLE if none
+  // distances[i][v] is the distance from sources[i] to v
+  void distances(const std::vector<VERTEX_ID> &sources,
+                 std::vector<std::vector<uint32_t>> &distances);
+
+  // the eccentricity of every source, the distance to the farthest vertex
+  // it reaches
+  std::vector<uint32_t> eccentricity(const std::vector<VERTEX_ID> &sources);
+
+private:
+  const CsrGraph &m_csr;
+  std::vector<LANES> m_seen;
+  std::vector<LANES> m_frontier;
+  std::vector<LANES> m_next;
+  std::vector<VERTEX_ID> m_active;  // vertices with a non-empty frontier
+  std::vector<VERTEX_ID> m_touched; // vertices with a non-empty next
+};
+
+template <typename VISIT>
+void MultiSourceBfs::run(const VERTEX_ID *sources, const size_t count,
+                         VISIT visit, const bool include_sources) {
+  std::fill(m_seen.begin(), m_seen.end(), 0);
+  m_active.clear();
+  for (size_t i = 0; i < count && i < MAX_SOURCES; ++i) {
+    VERTEX_ID const s = sources[i];
+    if (m_frontier[s] == 0) {
+      m_active.push_back(s);
+    }
+    m_frontier[s] |= static_cast<LANES>(1) << i;
+  }
+  if (include_sources) {
+    for (VERTEX_ID const s : m_active) {
+      m_seen[s] = m_frontier[s];
+      visit(s, m_frontier[s], 0);
+    }
+  }
+
+  for (size_t depth = 1; !m_active.empty(); ++depth) {
+    // push the frontier of every active vertex to its targets
+    m_touched.clear();
+    for (VERTEX_ID const v : m_active) {
+      LANES const lanes = m_frontier[v];
+      m_frontier[v] = 0;
+      for (uint32_t i = m_csr.begin(v); i < m_csr.end(v); ++i) {
+        VERTEX_ID const w = m_csr.targets[i];
+        if (m_next[w] == 0) {
+          m_touched.push_back(w);
+        }
+        m_next[w] |= lanes;
+      }
+    }
+
+    // the lanes reaching a vertex for the first time make the next frontier
+    m_active.clear();
+    for (VERTEX_ID const w : m_touched) {
+      LANES const lanes = m_next[w] & ~m_seen[w];
+      m_next[w] = 0;
+      if (lanes == 0) {
+        continue;
+      }
+      m_seen[w] |= lanes;
+      m_frontier[w] = lanes;
+      m_active.push_back(w);
+      visit(w, lanes, depth);
+    }
+  }
+}
+
+#endif
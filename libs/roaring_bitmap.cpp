@@ -0,0 +1,642 @@
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+#include <vector>
+
+#include "roaring_bitmap.h"
+
+using namespace std;
+
+// container
+
+bool RoaringBitMap::Container::contains(const uint16_t low) const {
+  switch (type) {
+  case ARRAY:
+    return binary_search(values.begin(), values.end(), low);
+  case BITSET:
+    return ((bits[low / MARKER_BLOCK_BITS] >> (low % MARKER_BLOCK_BITS)) & 1);
+  case RUN: {
+    // the last run starting at or before low
+    size_t lo = 0, hi = values.size() / 2;
+    while (lo < hi) {
+      size_t mid = (lo + hi) / 2;
+      if (values[2 * mid] <= low) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+    if (lo == 0) {
+      return false;
+    }
+    size_t start = values[2 * (lo - 1)];
+    return (low <= start + values[2 * (lo - 1) + 1]);
+  }
+  }
+  return false;
+}
+
+bool RoaringBitMap::Container::add(const uint16_t low) {
+  unpack();
+  if (type == ARRAY) {
+    auto it = lower_bound(values.begin(), values.end(), low);
+    if (it != values.end() && *it == low) {
+      return false;
+    }
+    values.insert(it, low);
+    if (++cardinality > ARRAY_MAX) {
+      toBitset();
+    }
+    return true;
+  }
+
+  MARKER_BLOCK mask = static_cast<MARKER_BLOCK>(1) << (low % MARKER_BLOCK_BITS);
+  MARKER_BLOCK &block = bits[low / MARKER_BLOCK_BITS];
+  if (block & mask) {
+    return false;
+  }
+  block |= mask;
+  ++cardinality;
+  return true;
+}
+
+bool RoaringBitMap::Container::remove(const uint16_t low) {
+  unpack();
+  if (type == ARRAY) {
+    auto it = lower_bound(values.begin(), values.end(), low);
+    if (it == values.end() || *it != low) {
+      return false;
+    }
+    values.erase(it);
+    --cardinality;
+    return true;
+  }
+
+  MARKER_BLOCK mask = static_cast<MARKER_BLOCK>(1) << (low % MARKER_BLOCK_BITS);
+  MARKER_BLOCK &block = bits[low / MARKER_BLOCK_BITS];
+  if ((block & mask) == 0) {
+    return false;
+  }
+  block &= ~mask;
+  if (--cardinality <= ARRAY_MAX) {
+    toArray();
+  }
+  return true;
+}
+
+size_t RoaringBitMap::Container::runs() const {
+  size_t n = 0;
+  switch (type) {
+  case ARRAY:
+    for (size_t i = 0; i < values.size(); ++i) {
+      if (i == 0 || values[i] != values[i - 1] + 1) {
+        ++n;
+      }
+    }
+    break;
+  case BITSET: {
+    MARKER_BLOCK carry = 0;
+    for (size_t i = 0; i < CHUNK_BLOCKS; ++i) {
+      // a run starts at every 1 not preceded by a 1
+      n += __builtin_popcountll(bits[i] & ~((bits[i] << 1) | carry));
+      carry = bits[i] >> (MARKER_BLOCK_BITS - 1);
+    }
+    break;
+  }
+  case RUN:
+    n = values.size() / 2;
+    break;
+  }
+  return n;
+}
+
+void RoaringBitMap::Container::blocks(vector<MARKER_BLOCK> &out) const {
+  if (type == BITSET) {
+    out = bits;
+    return;
+  }
+
+  out.assign(CHUNK_BLOCKS, 0);
+  if (type == ARRAY) {
+    for (uint16_t v : values) {
+      out[v / MARKER_BLOCK_BITS] |= static_cast<MARKER_BLOCK>(1)
+                                    << (v % MARKER_BLOCK_BITS);
+    }
+    return;
+  }
+
+  for (size_t r = 0; r < values.size(); r += 2) {
+    size_t start = values[r];
+    size_t end = start + values[r + 1] + 1;
+    size_t first = start / MARKER_BLOCK_BITS;
+    size_t last = (end - 1) / MARKER_BLOCK_BITS;
+    // runs may share their first and last blocks with the neighbours
+    for (size_t i = first; i <= last; ++i) {
+      MARKER_BLOCK block = ~static_cast<MARKER_BLOCK>(0);
+      if (i == first) {
+        block &= ~(BitMap::mask(start) - 1);
+      }
+      if (i == last) {
+        block &= BitMap::tail_mask(end);
+      }
+      out[i] |= block;
+    }
+  }
+}
+
+void RoaringBitMap::Container::assign(const MARKER_BLOCK *blocks) {
+  cardinality = BitMapKernel::active().count(blocks, CHUNK_BLOCKS);
+  if (cardinality > ARRAY_MAX) {
+    type = BITSET;
+    bits.assign(blocks, blocks + CHUNK_BLOCKS);
+    vector<uint16_t>().swap(values);
+    return;
+  }
+
+  type = ARRAY;
+  values.clear();
+  values.reserve(cardinality);
+  for (size_t i = 0; i < CHUNK_BLOCKS; ++i) {
+    for (MARKER_BLOCK b = blocks[i]; b != 0; b &= b - 1) {
+      values.push_back(
+          static_cast<uint16_t>(i * MARKER_BLOCK_BITS + __builtin_ctzll(b)));
+    }
+  }
+  vector<MARKER_BLOCK>().swap(bits);
+}
+
+void RoaringBitMap::Container::toBitset() {
+  if (type == BITSET) {
+    return;
+  }
+  vector<MARKER_BLOCK> out;
+  blocks(out);
+  bits.swap(out);
+  vector<uint16_t>().swap(values);
+  type = BITSET;
+}
+
+void RoaringBitMap::Container::toArray() {
+  if (type == ARRAY) {
+    return;
+  }
+  vector<MARKER_BLOCK> out;
+  blocks(out);
+  assign(out.data());
+  if (type != ARRAY) {
+    // too many bits, keep them as bitset
+    return;
+  }
+  values.shrink_to_fit();
+}
+
+void RoaringBitMap::Container::toRun() {
+  if (type == RUN) {
+    return;
+  }
+  vector<MARKER_BLOCK> in;
+  blocks(in);
+
+  vector<uint16_t> out;
+  out.reserve(2 * runs());
+  size_t start = 0;
+  bool inside = false;
+  for (size_t pos = 0; pos <= CHUNK_BITS; ++pos) {
+    bool bit = pos < CHUNK_BITS && ((in[pos / MARKER_BLOCK_BITS] >>
+                                     (pos % MARKER_BLOCK_BITS)) &
+                                    1);
+    if (bit && !inside) {
+      start = pos;
+      inside = true;
+    } else if (!bit && inside) {
+      out.push_back(static_cast<uint16_t>(start));
+      out.push_back(static_cast<uint16_t>(pos - start - 1));
+      inside = false;
+    }
+  }
+
+  values.swap(out);
+  vector<MARKER_BLOCK>().swap(bits);
+  type = RUN;
+}
+
+void RoaringBitMap::Container::optimize() {
+  size_t array_bytes = cardinality * sizeof(uint16_t);
+  size_t bitset_bytes = CHUNK_BLOCKS * sizeof(MARKER_BLOCK);
+  size_t run_bytes = runs() * 2 * sizeof(uint16_t);
+
+  if (run_bytes < min(array_bytes, bitset_bytes)) {
+    toRun();
+  } else if (cardinality <= ARRAY_MAX) {
+    toArray();
+  } else {
+    toBitset();
+  }
+  values.shrink_to_fit();
+}
+
+void RoaringBitMap::Container::unpack() {
+  if (type != RUN) {
+    return;
+  }
+  if (cardinality <= ARRAY_MAX) {
+    toArray();
+  } else {
+    toBitset();
+  }
+}
+
+bool RoaringBitMap::Container::subset(const Container &rhs) const {
+  if (cardinality > rhs.cardinality) {
+    return false;
+  }
+  if (type == ARRAY) {
+    for (uint16_t v : values) {
+      if (!rhs.contains(v)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  vector<MARKER_BLOCK> a, b;
+  blocks(a);
+  rhs.blocks(b);
+  return BitMapKernel::active().subset(a.data(), b.data(), CHUNK_BLOCKS);
+}
+
+size_t RoaringBitMap::Container::memory() const {
+  return (sizeof(Container) + values.capacity() * sizeof(uint16_t) +
+          bits.capacity() * sizeof(MARKER_BLOCK));
+}
+
+// bit map
+
+size_t RoaringBitMap::find(const size_t k) const {
+  return (lower_bound(m_keys.begin(), m_keys.end(), k) - m_keys.begin());
+}
+
+void RoaringBitMap::set() {
+  reset();
+  for (size_t k = 0; k * CHUNK_BITS < m_size; ++k) {
+    size_t len = min(CHUNK_BITS, m_size - k * CHUNK_BITS);
+    Container c;
+    c.type = Container::RUN;
+    c.cardinality = len;
+    c.values = {0, static_cast<uint16_t>(len - 1)};
+    m_keys.push_back(k);
+    m_containers.push_back(move(c));
+  }
+}
+
+void RoaringBitMap::set(const size_t pos) {
+  if (pos >= m_size) {
+    return;
+  }
+  size_t k = key(pos);
+  size_t i = find(k);
+  if (i == m_keys.size() || m_keys[i] != k) {
+    m_keys.insert(m_keys.begin() + i, k);
+    m_containers.insert(m_containers.begin() + i, Container());
+  }
+  m_containers[i].add(low(pos));
+}
+
+void RoaringBitMap::reset() {
+  m_keys.clear();
+  m_containers.clear();
+}
+
+void RoaringBitMap::reset(const size_t pos) {
+  if (pos >= m_size) {
+    return;
+  }
+  size_t k = key(pos);
+  size_t i = find(k);
+  if (i == m_keys.size() || m_keys[i] != k) {
+    return;
+  }
+  m_containers[i].remove(low(pos));
+  if (m_containers[i].cardinality == 0) {
+    m_keys.erase(m_keys.begin() + i);
+    m_containers.erase(m_containers.begin() + i);
+  }
+}
+
+bool RoaringBitMap::get(const size_t pos) const {
+  if (pos >= m_size) {
+    return false;
+  }
+  size_t k = key(pos);
+  size_t i = find(k);
+  if (i == m_keys.size() || m_keys[i] != k) {
+    return false;
+  }
+  return m_containers[i].contains(low(pos));
+}
+
+size_t RoaringBitMap::count() const {
+  size_t n = 0;
+  for (const Container &c : m_containers) {
+    n += c.cardinality;
+  }
+  return n;
+}
+
+void RoaringBitMap::assign(const BitMap &bitmap) {
+  if (bitmap.size() != m_size) {
+    throw out_of_range("can't assign bit map with different size");
+  }
+  reset();
+
+  BitMapView bits = bitmap.view();
+  vector<MARKER_BLOCK> chunk(CHUNK_BLOCKS, 0);
+  for (size_t k = 0; k * CHUNK_BLOCKS < bits.blocks(); ++k) {
+    const MARKER_BLOCK *begin = bits.data() + k * CHUNK_BLOCKS;
+    size_t len = min(CHUNK_BLOCKS, bits.blocks() - k * CHUNK_BLOCKS);
+    if (BitMapKernel::active().all0(begin, len)) {
+      continue;
+    }
+    if (len < CHUNK_BLOCKS) {
+      // the last chunk of the bit map is partial
+      fill(copy(begin, begin + len, chunk.begin()), chunk.end(), 0);
+      begin = chunk.data();
+    }
+
+    Container c;
+    c.assign(begin);
+    c.optimize();
+    m_keys.push_back(k);
+    m_containers.push_back(move(c));
+  }
+}
+
+void RoaringBitMap::optimize() {
+  for (Container &c : m_containers) {
+    c.optimize();
+  }
+  m_keys.shrink_to_fit();
+  m_containers.shrink_to_fit();
+}
+
+size_t RoaringBitMap::memory() const {
+  size_t n = sizeof(RoaringBitMap) + m_keys.capacity() * sizeof(size_t) +
+             (m_containers.capacity() - m_containers.size()) *
+                 sizeof(Container);
+  for (const Container &c : m_containers) {
+    n += c.memory();
+  }
+  return n;
+}
+
+bool RoaringBitMap::operator==(const RoaringBitMap &rhs) const {
+  if (m_size != rhs.m_size || m_keys != rhs.m_keys) {
+    return false;
+  }
+  for (size_t i = 0; i < m_containers.size(); ++i) {
+    // same number of bits and one is a subset of the other
+    if (m_containers[i].cardinality != rhs.m_containers[i].cardinality ||
+        !m_containers[i].subset(rhs.m_containers[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool RoaringBitMap::subset(const RoaringBitMap &rhs) const {
+  size_t j = 0;
+  for (size_t i = 0; i < m_keys.size(); ++i) {
+    while (j < rhs.m_keys.size() && rhs.m_keys[j] < m_keys[i]) {
+      ++j;
+    }
+    // containers are never empty
+    if (j == rhs.m_keys.size() || rhs.m_keys[j] != m_keys[i] ||
+        !m_containers[i].subset(rhs.m_containers[j])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+RoaringBitMap &RoaringBitMap::operator&=(const RoaringBitMap &rhs) {
+  vector<size_t> keys;
+  vector<Container> containers;
+  vector<MARKER_BLOCK> a, b;
+
+  size_t j = 0;
+  for (size_t i = 0; i < m_keys.size(); ++i) {
+    while (j < rhs.m_keys.size() && rhs.m_keys[j] < m_keys[i]) {
+      ++j;
+    }
+    if (j == rhs.m_keys.size()) {
+      break;
+    }
+    if (rhs.m_keys[j] != m_keys[i]) {
+      continue;
+    }
+
+    Container &lc = m_containers[i];
+    const Container &rc = rhs.m_containers[j];
+    Container c;
+    if (lc.type == Container::ARRAY || rc.type == Container::ARRAY) {
+      // filter the array by the other container
+      const Container &array = lc.type == Container::ARRAY ? lc : rc;
+      const Container &other = lc.type == Container::ARRAY ? rc : lc;
+      for (uint16_t v : array.values) {
+        if (other.contains(v)) {
+          c.values.push_back(v);
+        }
+      }
+      c.cardinality = c.values.size();
+    } else {
+      lc.blocks(a);
+      rc.blocks(b);
+      BitMapKernel::active().and_blocks(a.data(), b.data(), CHUNK_BLOCKS);
+      c.assign(a.data());
+    }
+
+    if (c.cardinality > 0) {
+      keys.push_back(m_keys[i]);
+      containers.push_back(move(c));
+    }
+  }
+
+  m_keys.swap(keys);
+  m_containers.swap(containers);
+  return *this;
+}
+
+RoaringBitMap &RoaringBitMap::operator|=(const RoaringBitMap &rhs) {
+  vector<size_t> keys;
+  vector<Container> containers;
+  vector<MARKER_BLOCK> a, b;
+  keys.reserve(m_keys.size() + rhs.m_keys.size());
+  containers.reserve(m_keys.size() + rhs.m_keys.size());
+
+  size_t i = 0, j = 0;
+  while (i < m_keys.size() || j < rhs.m_keys.size()) {
+    if (j == rhs.m_keys.size() ||
+        (i < m_keys.size() && m_keys[i] < rhs.m_keys[j])) {
+      keys.push_back(m_keys[i]);
+      containers.push_back(move(m_containers[i++]));
+      continue;
+    }
+    if (i == m_keys.size() || rhs.m_keys[j] < m_keys[i]) {
+      keys.push_back(rhs.m_keys[j]);
+      containers.push_back(rhs.m_containers[j++]);
+      continue;
+    }
+
+    Container &lc = m_containers[i];
+    const Container &rc = rhs.m_containers[j];
+    Container c;
+    if (lc.type == Container::ARRAY && rc.type == Container::ARRAY &&
+        lc.cardinality + rc.cardinality <= ARRAY_MAX) {
+      set_union(lc.values.begin(), lc.values.end(), rc.values.begin(),
+                rc.values.end(), back_inserter(c.values));
+      c.cardinality = c.values.size();
+    } else {
+      lc.blocks(a);
+      rc.blocks(b);
+      BitMapKernel::active().or_blocks(a.data(), b.data(), CHUNK_BLOCKS);
+      c.assign(a.data());
+    }
+    keys.push_back(m_keys[i]);
+    containers.push_back(move(c));
+    ++i, ++j;
+  }
+
+  m_keys.swap(keys);
+  m_containers.swap(containers);
+  if (rhs.m_size > m_size) {
+    trim();
+  }
+  return *this;
+}
+
+void RoaringBitMap::trim() {
+  if (m_size == 0) {
+    reset();
+    return;
+  }
+
+  size_t last = key(m_size - 1);
+  size_t i = find(last + 1);
+  m_keys.resize(i);
+  m_containers.resize(i);
+  if (i == 0 || m_keys[i - 1] != last) {
+    return;
+  }
+
+  // clear the bits beyond m_size in the last chunk
+  size_t limit = m_size - last * CHUNK_BITS;
+  if (limit == CHUNK_BITS) {
+    return;
+  }
+  vector<MARKER_BLOCK> bits;
+  m_containers[i - 1].blocks(bits);
+  size_t len = BitMap::blocks(limit);
+  fill(bits.begin() + len, bits.end(), 0);
+  bits[len - 1] &= BitMap::tail_mask(limit);
+  m_containers[i - 1].assign(bits.data());
+  if (m_containers[i - 1].cardinality == 0) {
+    m_keys.pop_back();
+    m_containers.pop_back();
+  }
+}
+
+// 2D bit map
+
+void RoaringBitMap2::set() {
+  for (RoaringBitMap &row : m_rows) {
+    row.set();
+  }
+}
+
+void RoaringBitMap2::reset() {
+  for (RoaringBitMap &row : m_rows) {
+    row.reset();
+  }
+}
+
+size_t RoaringBitMap2::memory() const {
+  size_t n = sizeof(RoaringBitMap2);
+  for (const RoaringBitMap &row : m_rows) {
+    n += row.memory();
+  }
+  return n;
+}
+
+const RoaringBitMap &RoaringBitMap2::operator[](const size_t row) const {
+  if (row >= m_row) {
+    throw out_of_range("2D bit map line access out of range");
+  }
+  return m_rows[row];
+}
+
+RoaringBitMap &RoaringBitMap2::row(const size_t row) {
+  if (row >= m_row) {
+    throw out_of_range("2D bit map line access out of range");
+  }
+  return m_rows[row];
+}
+
+bool RoaringBitMap2::all0() const {
+  for (const RoaringBitMap &row : m_rows) {
+    if (!row.all0()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool RoaringBitMap2::all1() const {
+  for (const RoaringBitMap &row : m_rows) {
+    if (!row.all1()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool RoaringBitMap2::operator>=(const RoaringBitMap2 &rhs) const {
+  if (m_row < rhs.m_row || m_col < rhs.m_col) {
+    return false;
+  }
+  for (size_t i = 0; i < rhs.m_row; ++i) {
+    if (!(m_rows[i] >= rhs.m_rows[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool RoaringBitMap2::operator<=(const RoaringBitMap2 &rhs) const {
+  return (rhs >= *this);
+}
+
+RoaringBitMap2 &RoaringBitMap2::operator&=(const RoaringBitMap2 &rhs) {
+  if (m_row != rhs.m_row || m_col != rhs.m_col) {
+    throw out_of_range("can't compare bit map with different size");
+  }
+  for (size_t i = 0; i < m_row; ++i) {
+    m_rows[i] &= rhs.m_rows[i];
+  }
+  return *this;
+}
+
+RoaringBitMap2 &RoaringBitMap2::operator|=(const RoaringBitMap2 &rhs) {
+  if (m_row != rhs.m_row || m_col != rhs.m_col) {
+    throw out_of_range("can't compare bit map with different size");
+  }
+  for (size_t i = 0; i < m_row; ++i) {
+    m_rows[i] |= rhs.m_rows[i];
+  }
+  return *this;
+}
+
+void RoaringBitMap2::optimize() {
+  for (RoaringBitMap &row : m_rows) {
+    row.optimize();
+  }
+}
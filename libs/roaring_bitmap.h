@@ -0,0 +1,192 @@
+#ifndef CASEGEN_ROARING_BITMAP_H_
+#define CASEGEN_ROARING_BITMAP_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "bitmap.h"
+
+// compressed bit map for sparse or clustered bits
+// the positions are split into 64K chunks by the high bits, every non-empty
+// chunk is kept in the smallest of 3 containers
+//   array:  sorted 16-bit low parts, for up to 4096 bits
+//   bitset: 1024 blocks of 64 bits, for dense chunks
+//   run:    sorted [start, length - 1] pairs, for long ranges of 1s
+// the interface follows BitMap
+class RoaringBitMap {
+public:
+  explicit RoaringBitMap(size_t size) : m_size(size){};
+  RoaringBitMap(const RoaringBitMap &rhs) = default;
+  RoaringBitMap(RoaringBitMap &&rhs) noexcept = default;
+  RoaringBitMap &operator=(const RoaringBitMap &rhs) = default;
+  RoaringBitMap &operator=(RoaringBitMap &&rhs) noexcept = default;
+  RoaringBitMap() = delete;
+  virtual ~RoaringBitMap() = default;
+
+  // set all bits to 1
+  void set();
+  // set the bit to 1 at pos
+  void set(const size_t pos);
+  // set all bits to 0
+  void reset();
+  // set the bit to 0 at pos
+  void reset(const size_t pos);
+  // get the val at pos
+  bool get(const size_t pos) const;
+  bool operator[](const size_t pos) const { return get(pos); };
+
+  // the capacity of bit map
+  size_t size() const { return m_size; };
+  // number of bits set to 1
+  size_t count() const;
+
+  bool all0() const { return m_keys.empty(); };
+  bool all1() const { return count() == m_size; };
+
+  // replace the content with the bits of a dense bit map of the same size
+  void assign(const BitMap &bitmap);
+
+  // convert every container to its smallest representation
+  void optimize();
+
+  // bytes used by the containers
+  size_t memory() const;
+
+  // compare
+  bool operator==(const RoaringBitMap &rhs) const;
+  bool operator!=(const RoaringBitMap &rhs) const { return !(*this == rhs); };
+  bool operator>=(const RoaringBitMap &rhs) const {
+    return (m_size >= rhs.m_size && rhs.subset(*this));
+  };
+  bool operator<=(const RoaringBitMap &rhs) const {
+    return (m_size <= rhs.m_size && subset(rhs));
+  };
+  bool operator>(const RoaringBitMap &rhs) const {
+    return (*this != rhs && *this >= rhs);
+  };
+  bool operator<(const RoaringBitMap &rhs) const {
+    return (*this != rhs && *this <= rhs);
+  };
+
+  // manipulate, the bits beyond size are dropped
+  RoaringBitMap &operator&=(const RoaringBitMap &rhs);
+  RoaringBitMap &operator|=(const RoaringBitMap &rhs);
+  RoaringBitMap operator&(const RoaringBitMap &rhs) const {
+    RoaringBitMap value(*this);
+    value &= rhs;
+    return value;
+  };
+  RoaringBitMap operator|(const RoaringBitMap &rhs) const {
+    RoaringBitMap value(*this);
+    value |= rhs;
+    return value;
+  };
+
+private:
+  static constexpr size_t CHUNK_BITS = 1 << 16;
+  static constexpr size_t CHUNK_BLOCKS = CHUNK_BITS / MARKER_BLOCK_BITS;
+  // an array container is converted to bitset above this cardinality
+  static constexpr size_t ARRAY_MAX = 4096;
+
+  struct Container {
+    enum TYPE { ARRAY = 0, BITSET, RUN };
+
+    TYPE type{ARRAY};
+    size_t cardinality{0};
+    // ARRAY: sorted values, RUN: start and length - 1 of every run
+    std::vector<uint16_t> values;
+    // BITSET: CHUNK_BLOCKS blocks
+    std::vector<MARKER_BLOCK> bits;
+
+    bool contains(const uint16_t low) const;
+    bool add(const uint16_t low);
+    bool remove(const uint16_t low);
+    // number of runs of 1s
+    size_t runs() const;
+    void toBitset();
+    void toArray();
+    void toRun();
+    void optimize();
+    // make the container mutable, run containers become array or bitset
+    void unpack();
+    // the bits as CHUNK_BLOCKS blocks
+    void blocks(std::vector<MARKER_BLOCK> &out) const;
+    // rebuild from CHUNK_BLOCKS blocks
+    void assign(const MARKER_BLOCK *blocks);
+    bool subset(const Container &rhs) const;
+    size_t memory() const;
+  };
+
+  static size_t key(const size_t pos) { return (pos >> 16); };
+  static uint16_t low(const size_t pos) {
+    return static_cast<uint16_t>(pos & 0xffff);
+  };
+
+  // index of the container of chunk k, or the insertion point
+  size_t find(const size_t k) const;
+  // the bits of this are all set in rhs
+  bool subset(const RoaringBitMap &rhs) const;
+  // drop the bits beyond m_size
+  void trim();
+
+  size_t m_size;
+  std::vector<size_t> m_keys; // sorted chunk keys
+  std::vector<Container> m_containers;
+};
+
+// 2D compressed bit map, one RoaringBitMap per row
+// the interface follows BitMap2
+class RoaringBitMap2 : public IBitMap2 {
+public:
+  RoaringBitMap2(const size_t row, const size_t col)
+      : m_row(row), m_col(col), m_rows(row, RoaringBitMap(col)){};
+
+  void set() override;
+  void set(const size_t i, const size_t j) override {
+    if (i < m_row && j < m_col) {
+      m_rows[i].set(j);
+    }
+  };
+  void reset() override;
+  void reset(const size_t i, const size_t j) override {
+    if (i < m_row && j < m_col) {
+      m_rows[i].reset(j);
+    }
+  };
+  bool get(const size_t i, const size_t j) const override {
+    if (i < m_row && j < m_col) {
+      return m_rows[i].get(j);
+    }
+    return false;
+  };
+  size_t size() const override { return m_row * m_col; };
+  size_t rows() const override { return m_row; };
+  size_t cols() const override { return m_col; };
+  size_t memory() const override;
+
+  const RoaringBitMap &operator[](const size_t row) const;
+  RoaringBitMap &row(const size_t row);
+
+  bool all0() const override;
+  bool all1() const override;
+  bool operator==(const RoaringBitMap2 &rhs) const {
+    return (m_row == rhs.m_row && m_col == rhs.m_col && m_rows == rhs.m_rows);
+  };
+  bool operator!=(const RoaringBitMap2 &rhs) const { return !(*this == rhs); };
+  bool operator>=(const RoaringBitMap2 &rhs) const;
+  bool operator<=(const RoaringBitMap2 &rhs) const;
+
+  RoaringBitMap2 &operator&=(const RoaringBitMap2 &rhs);
+  RoaringBitMap2 &operator|=(const RoaringBitMap2 &rhs);
+
+  // compress every row
+  void optimize();
+
+private:
+  size_t m_row;
+  size_t m_col;
+  std::vector<RoaringBitMap> m_rows;
+};
+
+#endif
@@ -7,6 +7,7 @@
 #include <cstddef>
 #include <fstream>
 #include <iostream>
+#include <sstream>
 #include <string>
 #include <vector>
 
@@ -16,33 +17,30 @@ Graph *StateMachine::generate(const size_t rows, const size_t cols,
     return nullptr;
   }
 
-  vector<BitMap *> states_attr;
+  vector<BitMap> states_attr;
+  states_attr.reserve(rows);
   m_stateGraph.init(rows);
 
   // create all states
   bool error = false;
   for (size_t i = 0; i < rows && !error; ++i) {
-    BitMap *attr = new BitMap(cols);
+    states_attr.emplace_back(cols);
+    BitMap &attr = states_attr.back();
     for (size_t j = 0; j < cols && !error; ++j) {
       switch (states[i][j]) {
       case 0:
-        attr->reset(j);
+        attr.reset(j);
         break;
       case 1:
-        attr->set(j);
+        attr.set(j);
         break;
       default: // only accept 0 or 1 as input
         error = true;
         break;
       }
     }
-    states_attr.push_back(attr);
   }
   if (error) {
-    for (size_t i = 0; i < states_attr.size(); ++i) {
-      delete states_attr[i];
-    }
-    states_attr.clear();
     return nullptr;
   }
 
@@ -53,17 +51,19 @@ Graph *StateMachine::generate(const size_t rows, const size_t cols,
   // the possible onnections between 2 states is one bit difference on the
   // feature sets that means it is switchable by one stop to turn on/off one
   // feature
+  // the different bits are counted without building the XOR bit map, and only
+  // the 1 bit neighbours are asked for the position
   vector<size_t> attr_diff;
   for (size_t i = 0; i < rows; ++i) {
     for (size_t j = 0; j < rows; ++j) {
-      if (i == j) {
+      if (i == j || states_attr[i].count_diff(states_attr[j]) != 1) {
         continue;
       }
-      states_attr[i]->diff(*states_attr[j], attr_diff);
+      states_attr[i].diff(states_attr[j], attr_diff);
       if (attr_diff.size() == 1) {
         EDGE_TYPE edge_type =
             attr_diff[0] +
-            static_cast<size_t>(states_attr[i]->get(attr_diff[0])) * cols;
+            static_cast<size_t>(states_attr[i].get(attr_diff[0])) * cols;
         m_stateGraph.link(i, j, edge_type);
         cout << "add link " << i << ", " << j << '\n';
       }
@@ -96,8 +96,19 @@ void StateMachine::load(const string &matrix_file) {
 }
 
 string StateMachine::cases() {
+  ostringstream out;
+  cases(out);
+  return out.str();
+}
+
+void StateMachine::cases(ostream &out) {
+  StreamSink sink(out);
+  cases(sink);
+}
+
+void StateMachine::cases(CaseSink &sink) {
   if (nullptr == m_pTrasition) {
-    return "";
+    return;
   }
 
   if (m_pTrasition->algorithm() == IGraphTraveller::GT_EULER &&
@@ -105,10 +116,7 @@ string StateMachine::cases() {
     m_stateGraph.eulerize();
   }
 
-  string trace;
-  m_pTrasition->travel(m_stateGraph, trace);
-  return trace;
-  // return m_pTrasition->print();
+  m_pTrasition->travel(m_stateGraph, sink);
 }
 
 void StateMachine::configure(const Properties &config) {
@@ -11,6 +11,7 @@
 
 #include <cstddef>
 #include <memory>
+#include <ostream>
 #include <string>
 #include <vector>
 
@@ -20,9 +21,25 @@ public:
   void load(const std::string &state_file);
 
   std::string cases();
+  // write the cases to out, the Euler tour is written while it is built
+  void cases(std::ostream &out);
+  // hand every case over to the sink as soon as it is found
+  void cases(CaseSink &sink);
 
   void configure(const Properties &config);
 
+  // storage of the reachable table, set it before load/generate for big
+  // graphs to avoid scanning twice
+  void setReachPolicy(Graph::REACH_POLICY policy) {
+    m_stateGraph.setReachPolicy(policy);
+  };
+  void setScanMethod(Graph::SCAN_METHOD method) {
+    m_stateGraph.setScanMethod(method);
+  };
+  void setScanThreads(const size_t threads) {
+    m_stateGraph.setScanThreads(threads);
+  };
+
   size_t size() const { return m_stateGraph.size(); };
 
 private:
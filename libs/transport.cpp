@@ -0,0 +1,195 @@
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include "transport.h"
+
+using namespace std;
+
+Transportation::Transportation(const vector<uint32_t> &supply,
+                               const vector<uint32_t> &demand,
+                               const vector<vector<uint32_t>> &cost)
+    : m_supply(supply), m_demand(demand), m_route_cost(cost),
+      m_flow(supply.size(), vector<uint32_t>(demand.size(), 0)),
+      m_potential(supply.size() + demand.size() + 2, 0) {
+  if (cost.size() != supply.size()) {
+    throw invalid_argument("cost rows do not match the sources");
+  }
+  for (const vector<uint32_t> &row : cost) {
+    if (row.size() != demand.size()) {
+      throw invalid_argument("cost columns do not match the sinks");
+    }
+  }
+}
+
+void Transportation::solve() {
+  // primal-dual: the shortest path distances move the potentials, then the
+  // flow is pushed on all the shortest paths at once, a blocking flow on the
+  // arcs of reduced cost 0, until none is left
+  // the costs are path lengths, so there are few distinct distances and few
+  // rounds
+  while (price()) {
+    while (level()) {
+      m_next.assign(nodes(), 0);
+      while (push(source(), static_cast<uint32_t>(-1)) > 0) {
+      }
+    }
+  }
+}
+
+bool Transportation::arc(const size_t u, const size_t k, size_t &v,
+                         int64_t &cost, uint32_t &capacity) const {
+  // the residual arcs of u, k-th one
+  //   S -> source i         while i has supply left, cost 0
+  //   source i -> sink j    if there is a route, cost[i][j], no capacity limit
+  //   sink j -> source i    while flow[i][j] > 0, -cost[i][j]
+  //   sink j -> T           while j has demand left, cost 0
+  // the arcs back to S or from T are never on a shortest path from S to T
+  size_t const m = m_supply.size();
+  capacity = 0;
+  if (u == source()) {
+    v = k;
+    cost = 0;
+    capacity = m_supply[k];
+  } else if (u < m) {
+    v = m + k;
+    cost = m_route_cost[u][k];
+    if (m_route_cost[u][k] != NO_ROUTE) {
+      capacity = static_cast<uint32_t>(-1);
+    }
+  } else if (u != sink()) {
+    size_t const j = u - m;
+    if (k < m) {
+      v = k;
+      cost = -static_cast<int64_t>(m_route_cost[k][j]);
+      capacity = m_flow[k][j];
+    } else {
+      v = sink();
+      cost = 0;
+      capacity = m_demand[j];
+    }
+  }
+  return capacity > 0;
+}
+
+size_t Transportation::arcs(const size_t u) const {
+  size_t const m = m_supply.size();
+  if (u == source()) {
+    return m;
+  }
+  if (u < m) {
+    return m_demand.size();
+  }
+  if (u != sink()) {
+    return m + 1;
+  }
+  return 0;
+}
+
+bool Transportation::price() {
+  // dense Dijkstra on the reduced costs, which the potentials keep >= 0
+  int64_t const INF = numeric_limits<int64_t>::max();
+  size_t const none = static_cast<size_t>(-1);
+  vector<int64_t> distance(nodes(), INF);
+  vector<bool> done(nodes(), false);
+  distance[source()] = 0;
+  for (;;) {
+    size_t u = none;
+    for (size_t v = 0; v < nodes(); ++v) {
+      if (!done[v] && distance[v] != INF &&
+          (u == none || distance[v] < distance[u])) {
+        u = v;
+      }
+    }
+    if (u == none) {
+      break;
+    }
+    done[u] = true;
+
+    for (size_t k = 0; k < arcs(u); ++k) {
+      size_t v;
+      int64_t cost;
+      uint32_t capacity;
+      if (!arc(u, k, v, cost, capacity) || done[v]) {
+        continue;
+      }
+      int64_t const d = distance[u] + cost + m_potential[u] - m_potential[v];
+      distance[v] = min(distance[v], d);
+    }
+  }
+  if (distance[sink()] == INF) {
+    return false;
+  }
+
+  // the nodes left behind are never reached again, the arcs added by the
+  // flow only join reached nodes
+  for (size_t v = 0; v < nodes(); ++v) {
+    if (distance[v] != INF) {
+      m_potential[v] += distance[v];
+    }
+  }
+  return true;
+}
+
+bool Transportation::admissible(const size_t u, const size_t k, size_t &v,
+                                uint32_t &capacity) const {
+  int64_t cost;
+  return arc(u, k, v, cost, capacity) &&
+         cost + m_potential[u] - m_potential[v] == 0;
+}
+
+bool Transportation::level() {
+  // BFS levels of the admissible arcs, as Dinic
+  size_t const none = static_cast<size_t>(-1);
+  m_level.assign(nodes(), none);
+  vector<size_t> queue(1, source());
+  m_level[source()] = 0;
+  for (size_t head = 0; head < queue.size(); ++head) {
+    size_t const u = queue[head];
+    for (size_t k = 0; k < arcs(u); ++k) {
+      size_t v;
+      uint32_t capacity;
+      if (admissible(u, k, v, capacity) && m_level[v] == none) {
+        m_level[v] = m_level[u] + 1;
+        queue.push_back(v);
+      }
+    }
+  }
+  return m_level[sink()] != none;
+}
+
+uint32_t Transportation::push(const size_t u, const uint32_t units) {
+  if (u == sink()) {
+    return units;
+  }
+  // m_next[u] is the first arc of u which may still take flow
+  for (size_t &k = m_next[u]; k < arcs(u); ++k) {
+    size_t v;
+    uint32_t capacity;
+    if (!admissible(u, k, v, capacity) || m_level[v] != m_level[u] + 1) {
+      continue;
+    }
+    uint32_t const pushed = push(v, min(units, capacity));
+    if (pushed == 0) {
+      continue;
+    }
+
+    size_t const m = m_supply.size();
+    if (u == source()) {
+      m_supply[v] -= pushed;
+    } else if (u < m) {
+      m_flow[u][v - m] += pushed;
+      m_cost += static_cast<uint64_t>(pushed) * m_route_cost[u][v - m];
+    } else if (v == sink()) {
+      m_demand[u - m] -= pushed;
+      m_total += pushed;
+    } else {
+      m_flow[v][u - m] -= pushed;
+      m_cost -= static_cast<uint64_t>(pushed) * m_route_cost[v][u - m];
+    }
+    return pushed;
+  }
+  return 0;
+}
@@ -0,0 +1,65 @@
+#ifndef CASEGEN_TRANSPORT_H_
+#define CASEGEN_TRANSPORT_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// transportation problem: supply[i] units leave source i, demand[j] units
+// arrive at sink j, a unit from i to j costs cost[i][j], NO_ROUTE if i can not
+// send to j
+// solved as a min-cost flow by the primal-dual method, Dijkstra with
+// potentials on the residual graph then blocking flows on its shortest paths,
+// so the flow is the largest one that can be sent and has the lowest total
+// cost among them
+class Transportation {
+public:
+  static constexpr uint32_t NO_ROUTE = static_cast<uint32_t>(-1);
+
+  Transportation(const std::vector<uint32_t> &supply,
+                 const std::vector<uint32_t> &demand,
+                 const std::vector<std::vector<uint32_t>> &cost);
+
+  // flow()[i][j] units go from source i to sink j
+  void solve();
+
+  const std::vector<std::vector<uint32_t>> &flow() const { return m_flow; };
+  uint64_t total() const { return m_total; };    // units sent
+  uint64_t totalCost() const { return m_cost; }; // sum of flow * cost
+
+private:
+  // the nodes of the flow network are the sources, the sinks, then a super
+  // source S and a super sink T
+  size_t nodes() const { return m_supply.size() + m_demand.size() + 2; };
+  size_t source() const { return m_supply.size() + m_demand.size(); };
+  size_t sink() const { return m_supply.size() + m_demand.size() + 1; };
+  // number of arcs out of u, residual or not
+  size_t arcs(const size_t u) const;
+  // the k-th arc out of u to v, false if it has no residual capacity
+  bool arc(const size_t u, const size_t k, size_t &v, int64_t &cost,
+           uint32_t &capacity) const;
+  // a residual arc of reduced cost 0
+  bool admissible(const size_t u, const size_t k, size_t &v,
+                  uint32_t &capacity) const;
+
+  // shortest paths from S, moves the potentials, false if T is not reached
+  bool price();
+  // levels of the admissible arcs from S, false if T is not reached
+  bool level();
+  // push up to units from u to T on the levels, the units pushed
+  uint32_t push(const size_t u, const uint32_t units);
+
+  std::vector<uint32_t> m_supply; // supply left
+  std::vector<uint32_t> m_demand; // demand left
+  std::vector<std::vector<uint32_t>> m_route_cost;
+  std::vector<std::vector<uint32_t>> m_flow;
+  uint64_t m_total{0};
+  uint64_t m_cost{0};
+
+  // potentials of the nodes of the residual graph
+  std::vector<int64_t> m_potential;
+  std::vector<size_t> m_level;
+  std::vector<size_t> m_next; // current arc of every node
+};
+
+#endif
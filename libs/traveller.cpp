@@ -2,21 +2,44 @@
 #include "graph.h"
 
 #include <algorithm>
+#include <atomic>
 #include <climits>
 #include <cstring>
+#include <functional>
 #include <iostream>
 #include <memory>
+#include <mutex>
 #include <queue>
 #include <sstream>
 #include <stack>
 #include <stdexcept>
 #include <string>
+#include <thread>
 #include <vector>
 
+#include "atomic_bitmap.h"
 #include "bitmap.h"
+#include "workers.h"
 
 using namespace std;
 
+namespace {
+
+// the vertices (or walks) are handed out to the Euler workers by chunks
+const size_t EULER_CHUNK = 4096;
+
+// the search tree of BfsAll is cut into this many subtrees per worker, no
+// deeper than SPLIT_DEPTH
+const size_t TASKS_PER_WORKER = 16;
+const size_t SPLIT_DEPTH = 12;
+
+// the links of the paths a BfsAll task holds before they are handed over to
+// the sink under the lock, a canonical task holds no more until all the tasks
+// before it are handed over
+const size_t CASE_BATCH = 1 << 16;
+
+} // namespace
+
 std::shared_ptr<IGraphTraveller>
 IGraphTraveller::createInstance(GT_ALGORITHM algorithm) {
   IGraphTraveller *pInstance = nullptr;
@@ -38,12 +61,24 @@ IGraphTraveller::createInstance(GT_ALGORITHM algorithm) {
   }
 }
 
-void GraphTravellerDfs::travel(const Graph &g, string &trace) {
+void IGraphTraveller::travel(const Graph &g, string &trace) {
+  ostringstream out;
+  stream(g, out);
+  trace = out.str();
+}
+
+void IGraphTraveller::stream(const Graph &g, ostream &out) {
+  StreamSink sink(out);
+  travel(g, sink);
+}
+
+void GraphTravellerDfs::travel(const Graph &g, CaseSink &sink) {
   if (g.size() == 0) {
     return;
   }
 
   startOver(g);
+  const CsrGraph &csr = g.csr();
   vector<VERTEX_ID> endpoints;
   LinkList backtrack(g.size(), nullptr);
 
@@ -51,7 +86,9 @@ void GraphTravellerDfs::travel(const Graph &g, string &trace) {
   stack<VERTEX_ID> s;
   s.push(g.getVertices()[start]->id);
   visit(0);
-  backtrack[0] = g.getAdjacencies(start)[0];
+  if (csr.degree(start) > 0) {
+    backtrack[0] = g.getLink(csr.edge_ids[csr.begin(start)]);
+  }
 
   while (!s.empty()) {
     // get the top element from the stack
@@ -63,11 +100,10 @@ void GraphTravellerDfs::travel(const Graph &g, string &trace) {
 
     // exercise the vertex
     // push all the unvisited neighbor of this vertex in to stack
-    LinkList adj = g.getAdjacencies(v);
     bool path_terminated =
         true; // if can't go further, mark the vertex as terminator
-    for (size_t i = 0; i < adj.size(); ++i) {
-      VERTEX_ID const w = adj[i]->to->id;
+    for (uint32_t i = csr.begin(v); i < csr.end(v); ++i) {
+      VERTEX_ID const w = csr.targets[i];
       if (isVisited(w)) {
         continue;
       }
@@ -76,92 +112,91 @@ void GraphTravellerDfs::travel(const Graph &g, string &trace) {
       path_terminated = false;
 
       // track the path
-      backtrack[w] = adj[i];
+      backtrack[w] = g.getLink(csr.edge_ids[i]);
     }
     if (path_terminated) {
       endpoints.push_back(v);
     }
   }
-  cout << "finished" << '\n';
+  vector<LINK_ID> links;
   for (size_t i = 0; i < endpoints.size(); ++i) {
-    trace += print(start, endpoints[i], backtrack);
+    VERTEX_ID const first = path(start, endpoints[i], backtrack, links);
+    sink.emit(g, first, links.data(), links.size());
   }
 }
 
 void GraphTravellerDfs::startOver(const Graph &g) {
   // reset visit table
-  if (m_visit_table) {
-    delete m_visit_table;
-  }
-  m_visit_table = new BitMap(g.size());
+  m_visit_table.assign(g.size());
 }
 
 void GraphTravellerDfs::visit(const VERTEX_ID v_id, const bool mark) {
-  if (nullptr == m_visit_table) {
-    throw std::runtime_error("visit table is null");
+  if (0 == m_visit_table.size()) {
+    throw std::runtime_error("visit table is empty");
   }
 
   if (mark) {
-    m_visit_table->set(v_id);
+    m_visit_table.set(v_id);
   } else {
-    m_visit_table->reset(v_id);
+    m_visit_table.reset(v_id);
   }
 }
 
 bool GraphTravellerDfs::isVisited(const VERTEX_ID v_id) const {
-  if (nullptr == m_visit_table) {
-    throw std::runtime_error("visit table is null");
+  if (0 == m_visit_table.size()) {
+    throw std::runtime_error("visit table is empty");
   }
 
-  return m_visit_table->get(v_id);
+  return m_visit_table.get(v_id);
 }
 
-string GraphTravellerDfs::print(const VERTEX_ID start, const VERTEX_ID end,
-                                const LinkList &backtrack) const {
-  string path;
+VERTEX_ID GraphTravellerDfs::path(const VERTEX_ID start, const VERTEX_ID end,
+                                  const LinkList &backtrack,
+                                  vector<LINK_ID> &links) const {
   Link *link = backtrack[end];
   if (nullptr == link) {
     throw std::runtime_error("trace link is null");
   }
 
+  // backwards from end
+  links.clear();
+  VERTEX_ID first = end;
   while (!link->circle()) {
-    path = "--" + link->edge->name() + "-->" + link->target->name() + path;
-    if (link->source->id == start) {
-      path = "\n" + link->source->name() + path;
+    links.push_back(link->edge.id);
+    first = link->source.id;
+    if (link->source.id == start) {
       break;
     }
-    link = backtrack[link->source->id];
+    link = backtrack[link->source.id];
   }
-
-  path += "\n";
-  return path;
+  reverse(links.begin(), links.end());
+  return first;
 }
 
-void GraphTravellerDfsPath::travel(const Graph &g, string &trace) {
+void GraphTravellerDfsPath::travel(const Graph &g, CaseSink &sink) {
   if (g.size() == 0) {
     return;
   }
 
   startOver(g);
 
-  for (LINK_ID e = 0; e < g.getLinks().size(); ++e) {
-    // get a path has not been walked
-    if (isVisited(e)) {
-      continue;
-    }
-    travel(g, e, trace);
+  // start a new path from every edge has not been walked
+  // the walk only marks edges, so the scan always moves forward
+  for (size_t e = m_visit_table.find_first_unset(); e != BitMap::npos;
+       e = m_visit_table.find_next_unset(e)) {
+    travel(g, e, sink);
   }
 }
 
 void GraphTravellerDfsPath::travel(const Graph &g, const LINK_ID e,
-                                   string &trace) {
+                                   CaseSink &sink) {
   LinkList backtrack;
 
   Link *link = g.getLink(e);
   backtrack.push_back(g.getLink(e));
   visit(e);
 
-  VERTEX_ID const start = link->source->id;
+  VERTEX_ID const start = link->source.id;
   size_t uncover = 1;
   while (uncover != 0) {
     if (nullptr == link) {
@@ -170,9 +205,8 @@ void GraphTravellerDfsPath::travel(const Graph &g, const LINK_ID e,
 
     // test the destination vertex of this edge
     // get one edge start from it
-    LinkList adj = g.getAdjacencies(link->target->id);
     LINK_ID x;
-    uncover = mostChoice(g, link->target->id, 1, x);
+    uncover = mostChoice(g, link->target.id, 1, x);
     if (uncover == 0) {
       break;
     }
@@ -181,42 +215,33 @@ void GraphTravellerDfsPath::travel(const Graph &g, const LINK_ID e,
     link = g.getLink(x);
     backtrack.push_back(link);
   }
-  trace += print(start, link->target->id, backtrack) + "\n";
+  sink.beginCase(g, start);
+  for (Link *const l : backtrack) {
+    sink.append(l->edge.id);
+  }
+  sink.endCase();
 }
 
 void GraphTravellerDfsPath::startOver(const Graph &g) {
   // reset visit table, it is the visit bit for edges
-  if (m_visit_table) {
-    delete m_visit_table;
-  }
-  m_visit_table = new BitMap(g.getLinks().size());
-}
-
-string GraphTravellerDfsPath::print(const VERTEX_ID start, const VERTEX_ID end,
-                                    const LinkList &backtrack) const {
-  string path = backtrack[0]->from->name();
-  for (size_t i = 0; i < backtrack.size(); ++i) {
-    path +=
-        "--" + backtrack[i]->edge->name() + "-->" + backtrack[i]->to->name();
-  }
-  return path;
+  m_visit_table.assign(g.getLinks().size());
 }
 
 size_t GraphTravellerDfsPath::uncoveredBranches(const Graph &g,
                                                 const VERTEX_ID v,
                                                 const size_t steps) const {
-  LinkList adj = g.getAdjacencies(v);
+  const CsrGraph &csr = g.csr();
 
   size_t uncover = 0;
   if (steps == 1) {
-    for (size_t i = 0; i < adj.size(); ++i) {
-      if (!isVisited(adj[i]->edge->id)) {
+    for (uint32_t i = csr.begin(v); i < csr.end(v); ++i) {
+      if (!isVisited(csr.edge_ids[i])) {
         ++uncover;
       }
     }
   } else {
-    for (size_t i = 0; i < adj.size(); ++i) {
-      uncover += uncoveredBranches(g, adj[i]->to->id, steps - 1);
+    for (uint32_t i = csr.begin(v); i < csr.end(v); ++i) {
+      uncover += uncoveredBranches(g, csr.targets[i], steps - 1);
     }
   }
 
@@ -226,76 +251,26 @@ size_t GraphTravellerDfsPath::uncoveredBranches(const Graph &g,
 LINK_ID GraphTravellerDfsPath::mostChoice(const Graph &g, const VERTEX_ID v,
                                           const size_t steps,
                                           LINK_ID &e) const {
-  LinkList adj = g.getAdjacencies(v);
+  const CsrGraph &csr = g.csr();
   size_t possibility = 0;
 
-  for (size_t i = 0; i < adj.size(); ++i) {
-    if (isVisited(adj[i]->edge->id)) {
+  for (uint32_t i = csr.begin(v); i < csr.end(v); ++i) {
+    if (isVisited(csr.edge_ids[i])) {
       continue;
     }
-    size_t const p = uncoveredBranches(g, adj[i]->to->id, steps);
+    size_t const p = uncoveredBranches(g, csr.targets[i], steps);
     if (possibility < p) {
       possibility = p;
-      e = adj[i]->edge->id;
+      e = csr.edge_ids[i];
     }
   }
 
   return possibility;
 }
 
-void GraphTravellerBfs::travel(const Graph &g, string &trace) {}
-
-LinkList GraphTravellerBfs::shortestPath(const Graph &graph, const Vertex &from,
-                                         const Vertex &to) {
-  if (!graph.reachable(from.id, to.id)) {
-    return nullptr;
-  }
-
-  LinkList visit_trace(graph.size(), nullptr);
-  BitMap visit_table(graph.size());
-  queue<VERTEX_ID> vid_q;
-  vid_q.push(from.id);
-
-  bool found = false;
-  while (!vid_q.empty() && !found) {
-    VERTEX_ID const vv = vid_q.front();
-    vid_q.pop();
-
-    LinkList adj(graph.getAdjacencies(vv).begin(),
-                 graph.getAdjacencies(vv).end());
-    random_shuffle(adj.begin(), adj.end());
-
-    visit_table.set(vv);
-    for (LinkList::iterator it = adj.begin(); it != adj.end(); ++it) {
-      VERTEX_ID const ww = (*it)->to->id;
-
-      if (to.id == ww) { // found, stop searching
-        visit_trace[ww] = (*it);
-        found = true;
-        break;
-      }
-
-      if (!visit_table.get(ww)) {
-        vid_q.push(ww);
-        visit_trace[ww] = (*it);
-      }
-    }
-  }
-  if (!found) {
-    return nullptr; // something wrong?
-  }
-
-  LinkList *path = new LinkList();
-  // set the path according to the visit trace
-  Link *link = visit_trace[to->id];
-  while (from.id != link->source->id && !link->circle()) {
-    path->insert(path->begin(), link);
-    link = visit_trace[link->source->id];
-  }
-  path->insert(path->begin(), link);
-
-  return path;
-}
+// the plain breadth first search only holds the visit bits shared by the
+// path searches, it has no path to look for and writes no case
+void GraphTravellerBfs::travel(const Graph &, CaseSink &) {}
 
 void GraphTravellerBfs::startOver(const Graph &g) {
   m_nodes = g.size();
@@ -317,8 +292,8 @@ void GraphTravellerBfs::visit(const VERTEX_ID v_id, const bool mark) {
     return;
   }
 
-  size_t const offset = v_id / MARKER_BLOCK_BITS;
-  size_t const bits = v_id % MARKER_BLOCK_BITS;
+  size_t const offset = v_id / CHAR_BIT;
+  size_t const bits = v_id % CHAR_BIT;
 
   char const mask = 1 << bits;
   if (mark) {
@@ -336,8 +311,8 @@ bool GraphTravellerBfs::isVisited(const VERTEX_ID v_id) const {
     return false;
   }
 
-  size_t const offset = v_id / MARKER_BLOCK_BITS;
-  size_t const bits = v_id % MARKER_BLOCK_BITS;
+  size_t const offset = v_id / CHAR_BIT;
+  size_t const bits = v_id % CHAR_BIT;
   char const mask = 1 << bits;
   return ((m_bits[offset] & mask) == mask);
 }
@@ -377,9 +352,19 @@ void GraphTravellerBfsAll::configure(const Properties &config) {
   } else {
     m_random = false;
   }
+
+  it = config.find("PARALLEL");
+  if (it != config.end() && it->second > 0) {
+    m_threads = it->second;
+  } else {
+    m_threads = 0;
+  }
+
+  it = config.find("CANONICAL");
+  m_canonical = (it != config.end() && it->second == 1);
 }
 
-void GraphTravellerBfsAll::travel(const Graph &g, string &trace) {
+void GraphTravellerBfsAll::travel(const Graph &g, CaseSink &sink) {
   if (!g.reachable(m_start, m_end)) {
     cerr << "no connectivity from node " << m_start << " to node " << m_end
          << '\n';
@@ -387,6 +372,13 @@ void GraphTravellerBfsAll::travel(const Graph &g, string &trace) {
   }
 
   startOver(g);
+  g.distancesTo(m_end, m_distance);
+  if (m_threads > 0) {
+    travelParallel(g, sink);
+    return;
+  }
+  m_sink = &sink;
+  m_graph = &g;
   m_path.push_back(m_start);
   if (m_start != m_end) {
     visit(m_start, true);
@@ -396,88 +388,393 @@ void GraphTravellerBfsAll::travel(const Graph &g, string &trace) {
 
 void GraphTravellerBfsAll::explore(const Graph &graph,
                                    VERTEX_ID current_node_id) {
+  // depth first on an explicit stack of frames, one per vertex of m_path,
+  // the buffers keep their capacity so no allocation is done once they are
+  // as deep as the search
+  const CsrGraph &csr = graph.csr();
+  m_frames.clear();
+  m_adj.clear();
+  if (!enter(csr, current_node_id)) {
+    return;
+  }
+
+  while (!m_frames.empty()) {
+    size_t const top = m_frames.size() - 1;
+    // the next adjacent node to visit
+    bool descended = false;
+    while (!descended && m_frames[top].next < m_frames[top].last) {
+      uint32_t const k = m_frames[top].next++;
+      uint32_t const link = m_random ? m_adj[k] : k;
+      VERTEX_ID const neighbor = csr.targets[link];
+      if (neighbor == m_end || isVisited(neighbor)) {
+        // it is destination or has bee visited
+        continue;
+      }
+      // a pruned neighbor is not entered, so its links are not shuffled on a
+      // random walk and the walks after it take other random numbers
+      if (m_distance[neighbor] == Graph::NO_DISTANCE) {
+        // the destination can not be reached from there
+        continue;
+      }
+      if (m_found > 0 && top + 1 + m_distance[neighbor] > m_max_depth) {
+        // a path through there is too long, the depth is limited once a path
+        // is found and m_found only grows
+        continue;
+      }
+
+      m_path.push_back(csr.edge_ids[link]);
+      m_path.push_back(neighbor);
+      m_case.push_back(csr.edge_ids[link]);
+      visit(neighbor, true);
+      descended = enter(csr, neighbor);
+      if (!descended) {
+        visit(neighbor, false);
+        m_path.pop_back();
+        m_path.pop_back();
+        m_case.pop_back();
+      }
+    }
+    if (descended) {
+      continue;
+    }
+
+    // all the adjacent nodes are done, back to the previous one
+    if (m_random) {
+      m_adj.resize(m_frames[top].first);
+    }
+    m_frames.pop_back();
+    if (!m_frames.empty()) {
+      visit(m_path.back(), false);
+      m_path.pop_back();
+      m_path.pop_back();
+      m_case.pop_back();
+    }
+  }
+}
+
+bool GraphTravellerBfsAll::enter(const CsrGraph &csr, const VERTEX_ID v) {
   // continue search if not reach the limit
   if (!searchFurther()) {
-    return;
+    return false;
   }
 
-  // get adjacencies of current node
-  LinkList adj(graph.getAdjacencies(current_node_id).begin(),
-               graph.getAdjacencies(current_node_id).end());
+  // adjacencies of the node, as positions in the CSR arrays, a shuffled copy
+  // on top of m_adj for a random walk
+  Frame frame{csr.begin(v), csr.end(v), csr.begin(v)};
   if (m_random) {
-    random_shuffle(adj.begin(), adj.end());
+    frame.first = frame.next = m_adj.size();
+    for (uint32_t i = csr.begin(v); i < csr.end(v); ++i) {
+      m_adj.push_back(i);
+    }
+    frame.last = m_adj.size();
+    random_shuffle(m_adj.begin() + frame.first, m_adj.end());
   }
 
   // examine adjacent nodes
-  VERTEX_ID neighbor;
-  for (auto const &link : adj) {
-    neighbor = (*link)->to->id;
+  for (uint32_t k = frame.first; k < frame.last && m_found < m_max_cases;
+       ++k) {
+    uint32_t const link = m_random ? m_adj[k] : k;
+    VERTEX_ID const neighbor = csr.targets[link];
     if (neighbor != m_start && isVisited(neighbor)) {
       // the node has been visited in this path
       continue;
     }
 
     if (neighbor == m_end) {
-      // reach the destination
-      m_path.push_back((*link)->edge->id);
-      m_path.push_back(neighbor);
-      visit(neighbor, true);
+      // reach the destination, the links of m_path and the last one
+      m_case.push_back(csr.edge_ids[link]);
       ++m_found;
-      // cout << print() << endl;
-      visit(neighbor, false);
-      m_path.pop_back();
-      m_path.pop_back();
+      m_sink->emit(*m_graph, m_start, m_case.data(), m_case.size());
+      m_case.pop_back();
+    }
+  }
+
+  m_frames.push_back(frame);
+  return true;
+}
+
+void GraphTravellerBfsAll::travelParallel(const Graph &g, CaseSink &sink) {
+  const CsrGraph &csr = g.csr();
+  vector<char> visited(g.size(), 0);
+  visited[m_start] = (m_start != m_end);
+  vector<ELEMENT_ID> path(1, m_start);
+
+  // deeper until there are enough subtrees to keep the workers busy
+  vector<Task> tasks;
+  for (size_t depth = 0; depth <= SPLIT_DEPTH; ++depth) {
+    tasks.clear();
+    split(csr, depth, visited, path, tasks);
+    size_t subtrees = 0;
+    for (const Task &t : tasks) {
+      subtrees += t.subtree ? 1 : 0;
+    }
+    if (subtrees == 0 || subtrees >= m_threads * TASKS_PER_WORKER) {
+      break;
     }
   }
 
-  // recursively visit adjacent nodes
-  for (LinkList::iterator link = adj.begin(); link != adj.end(); ++link) {
-    neighbor = (*link)->to->id;
-    if (neighbor == m_end || isVisited(neighbor)) {
-      // it is destination or has bee visited
+  // dealt round robin, the workers take their tasks from the back and steal
+  // from the front
+  // canonical: the tasks are taken in order instead, so all the tasks before
+  // a task are taken and the first one not done never waits for the others
+  vector<unique_ptr<Worker>> workers;
+  for (size_t w = 0; w < m_threads; ++w) {
+    workers.emplace_back(new Worker(g.size()));
+  }
+  Run run(g, sink, tasks);
+  for (size_t t = 0; t < tasks.size(); ++t) {
+    Task &task = tasks[t];
+    if (task.subtree) {
+      if (!m_canonical) {
+        workers[t % m_threads]->tasks.push_back(t);
+      }
       continue;
     }
+    // the paths by one more link are found by the split
+    task.done = true;
+    if (!m_canonical) {
+      run.found += task.ends.size();
+      handOver(run, task);
+    }
+  }
+  if (m_canonical) {
+    flush(run);
+  }
+
+  atomic<size_t> next_worker(0);
+  runWorkers(m_threads, [this, &csr, &tasks, &workers, &run, &next_worker]() {
+    size_t const self = next_worker++;
+    Worker &me = *workers[self];
+    for (;;) {
+      size_t task = tasks.size();
+      if (m_canonical) {
+        for (size_t t = run.next++; t < tasks.size(); t = run.next++) {
+          if (tasks[t].subtree) {
+            task = t;
+            break;
+          }
+        }
+      } else {
+        lock_guard<mutex> guard(me.lock);
+        if (!me.tasks.empty()) {
+          task = me.tasks.back();
+          me.tasks.pop_back();
+        }
+      }
+      for (size_t k = 1; !m_canonical && task == tasks.size() &&
+                         k < workers.size();
+           ++k) {
+        Worker &victim = *workers[(self + k) % workers.size()];
+        lock_guard<mutex> guard(victim.lock);
+        if (!victim.tasks.empty()) {
+          task = victim.tasks.front();
+          victim.tasks.pop_front();
+        }
+      }
+      // no task is made after the split, all the deques are empty
+      if (task == tasks.size()) {
+        break;
+      }
+      // canonical: the tasks after MAX_CASES paths are not searched
+      if (!m_canonical || run.emitted < m_max_cases) {
+        search(csr, tasks[task], me, run);
+      }
+      lock_guard<mutex> guard(run.lock);
+      if (m_canonical) {
+        tasks[task].done = true;
+        flush(run);
+      } else {
+        handOver(run, tasks[task]);
+      }
+    }
+  });
 
-    m_path.push_back((*link)->edge->id);
-    m_path.push_back(neighbor);
-    visit(neighbor, true);
-    explore(graph, neighbor);
-    visit(neighbor, false);
-    m_path.pop_back();
-    m_path.pop_back();
+  m_found = run.emitted;
+}
+
+void GraphTravellerBfsAll::split(const CsrGraph &csr, const size_t depth,
+                                 vector<char> &visited,
+                                 vector<ELEMENT_ID> &path,
+                                 vector<Task> &tasks) const {
+  VERTEX_ID const v = path.back();
+  size_t const level = path.size() / 2;
+  if (level == depth) {
+    tasks.push_back(Task{path, true, 0});
+    return;
+  }
+
+  // the paths by one more link first, then the subtrees, as explore
+  if (level < m_max_depth) {
+    Task hits{path, false, 0};
+    for (uint32_t i = csr.begin(v);
+         i < csr.end(v) && hits.found < m_max_cases; ++i) {
+      if (!arrive(csr.targets[i], visited)) {
+        continue;
+      }
+      for (size_t k = 1; k < path.size(); k += 2) {
+        hits.cases.push_back(path[k]);
+      }
+      hits.cases.push_back(csr.edge_ids[i]);
+      hits.ends.push_back(hits.cases.size());
+      ++hits.found;
+    }
+    tasks.push_back(hits);
+  }
+  for (uint32_t i = csr.begin(v); i < csr.end(v); ++i) {
+    VERTEX_ID const neighbor = csr.targets[i];
+    if (!descend(neighbor, level + 1, visited)) {
+      continue;
+    }
+    path.push_back(csr.edge_ids[i]);
+    path.push_back(neighbor);
+    visited[neighbor] = 1;
+    split(csr, depth, visited, path, tasks);
+    visited[neighbor] = 0;
+    path.pop_back();
+    path.pop_back();
   }
 }
 
-void GraphTravellerBfsAll::startOver(const Graph &g) {
-  GraphTravellerBfs::startOver(g);
-  m_found = 0;
-  m_path.clear();
+bool GraphTravellerBfsAll::descend(const VERTEX_ID neighbor,
+                                   const size_t depth,
+                                   const vector<char> &visited) const {
+  return neighbor != m_end && !visited[neighbor] &&
+         m_distance[neighbor] != Graph::NO_DISTANCE &&
+         depth + m_distance[neighbor] <= m_max_depth;
 }
 
-string GraphTravellerBfsAll::print() const {
-  if (m_path.empty()) {
-    return "";
+void GraphTravellerBfsAll::search(const CsrGraph &csr, Task &task,
+                                  Worker &worker, Run &run) const {
+  // canonical: the task counts its own paths, otherwise all the workers
+  // stop at m_max_cases
+  auto stop = [this, &task, &run]() {
+    return m_canonical ? task.found >= m_max_cases || run.emitted >= m_max_cases
+                       : run.found.load(memory_order_relaxed) >= m_max_cases;
+  };
+  vector<char> &visited = worker.visited;
+  for (size_t i = 2; i < task.path.size(); i += 2) {
+    visited[task.path[i]] = 1;
+  }
+  visited[m_start] = (m_start != m_end);
+
+  // as explore, on the frames of the worker
+  size_t const root = task.path.size() / 2;
+  worker.frames.clear();
+  worker.vertices.clear();
+  worker.links.clear();
+  for (size_t i = 1; i < task.path.size(); i += 2) {
+    worker.links.push_back(task.path[i]);
+  }
+  VERTEX_ID v = task.path.back();
+  for (;;) {
+    // enter v, the paths to m_end by one more link
+    size_t const depth = root + worker.frames.size();
+    bool entered = depth < m_max_depth && !stop();
+    for (uint32_t i = csr.begin(v); entered && i < csr.end(v); ++i) {
+      if (!arrive(csr.targets[i], visited)) {
+        continue;
+      }
+      worker.links.push_back(csr.edge_ids[i]);
+      entered = accept(run, task, worker.links);
+      worker.links.pop_back();
+    }
+    if (entered) {
+      worker.frames.push_back(Frame{csr.begin(v), csr.end(v), csr.begin(v)});
+      worker.vertices.push_back(v);
+    } else if (!worker.frames.empty()) {
+      visited[v] = 0;
+      worker.links.pop_back();
+    }
+
+    // the next adjacent node to visit, back up the frames which are done
+    v = m_end;
+    while (!worker.frames.empty() && v == m_end) {
+      Frame &top = worker.frames.back();
+      size_t const level = root + worker.frames.size();
+      while (top.next < top.last && v == m_end) {
+        VERTEX_ID const neighbor = csr.targets[top.next++];
+        if (descend(neighbor, level, visited)) {
+          v = neighbor;
+        }
+      }
+      if (v == m_end) {
+        worker.frames.pop_back();
+        if (!worker.frames.empty()) {
+          visited[worker.vertices.back()] = 0;
+          worker.links.pop_back();
+        }
+        worker.vertices.pop_back();
+      }
+    }
+    if (v == m_end) {
+      break;
+    }
+    visited[v] = 1;
+    worker.links.push_back(csr.edge_ids[worker.frames.back().next - 1]);
   }
 
-  if (m_path.size() % 2 == 0) {
-    // there should be odd number of elements in the path
-    // something wrong
-    cout << "error there are " << m_path.size() << " elements in the path"
-         << '\n';
-    return "";
+  for (size_t i = 0; i < task.path.size(); i += 2) {
+    visited[task.path[i]] = 0;
   }
+}
 
-  stringstream path;
-  path << "S" << m_path[0];
-  size_t i = 1;
-  while (i < m_path.size()) {
-    path << "--E";
-    path << m_path[i++];
-    path << "-->S";
-    path << m_path[i++];
+bool GraphTravellerBfsAll::accept(Run &run, Task &task,
+                                  const vector<LINK_ID> &links) const {
+  if (m_canonical) {
+    if (task.found >= m_max_cases || run.emitted >= m_max_cases) {
+      return false;
+    }
+  } else if (run.found.fetch_add(1, memory_order_relaxed) >= m_max_cases) {
+    return false;
+  }
+  ++task.found;
+  task.cases.insert(task.cases.end(), links.begin(), links.end());
+  task.ends.push_back(task.cases.size());
+  if (task.cases.size() < CASE_BATCH) {
+    return true;
   }
 
-  return path.str();
+  // a batch, the tasks before a canonical task are handed over first
+  unique_lock<mutex> guard(run.lock);
+  // the wait is rare, the lock is left to the workers in between
+  size_t const index = &task - run.tasks.data();
+  while (m_canonical && run.flushed != index) {
+    guard.unlock();
+    this_thread::yield();
+    guard.lock();
+  }
+  handOver(run, task);
+  return true;
+}
+
+void GraphTravellerBfsAll::handOver(Run &run, Task &task) const {
+  // the caller holds run.lock
+  size_t first = 0;
+  for (size_t i = 0; i < task.ends.size() && run.emitted < m_max_cases; ++i) {
+    run.sink.emit(run.g, m_start, task.cases.data() + first,
+                  task.ends[i] - first);
+    first = task.ends[i];
+    ++run.emitted;
+  }
+  task.cases.clear();
+  task.ends.clear();
+}
+
+void GraphTravellerBfsAll::flush(Run &run) const {
+  // the caller holds run.lock
+  while (run.flushed < run.tasks.size() && run.tasks[run.flushed].done) {
+    Task &task = run.tasks[run.flushed++];
+    handOver(run, task);
+    vector<LINK_ID>().swap(task.cases);
+    vector<size_t>().swap(task.ends);
+  }
+}
+
+void GraphTravellerBfsAll::startOver(const Graph &g) {
+  GraphTravellerBfs::startOver(g);
+  m_found = 0;
+  m_path.clear();
+  m_case.clear();
 }
 
 bool GraphTravellerBfsAll::searchFurther() const {
@@ -490,44 +787,62 @@ bool GraphTravellerBfsAll::searchFurther() const {
   return (m_found == 0 || (m_path.size() / 2) < m_max_depth);
 }
 
-void GraphTravellerBfsOne::travel(const Graph &g, string &trace) {
+void GraphTravellerBfsOne::travel(const Graph &g, CaseSink &sink) {
   if (!g.reachable(m_start, m_end)) {
     cerr << "no connectivity from node " << m_start << " to node " << m_end
          << '\n';
     return;
   }
 
+  const CsrGraph &csr = g.csr();
   m_backtrack.resize(g.size(), nullptr);
   BitMap visit_table(g.size());
   queue<VERTEX_ID> q;
   q.push(m_start);
 
+  vector<uint32_t> adj;
   bool found = false;
   while (!q.empty() && !found) {
     VERTEX_ID const v = q.front();
     q.pop();
 
-    LinkList adj(g.getAdjacencies(v).begin(), g.getAdjacencies(v).end());
+    adj.clear();
+    for (uint32_t i = csr.begin(v); i < csr.end(v); ++i) {
+      adj.push_back(i);
+    }
     if (m_random) {
       random_shuffle(adj.begin(), adj.end());
     }
 
     visit_table.set(v);
-    for (LinkList::iterator it = adj.begin(); it != adj.end(); ++it) {
-      VERTEX_ID const w = (*it)->to->id;
+    for (uint32_t const i : adj) {
+      VERTEX_ID const w = csr.targets[i];
       if (m_end == w) { // found, stop searching
-        m_backtrack[w] = *it;
+        m_backtrack[w] = g.getLink(csr.edge_ids[i]);
         found = true;
         break;
       }
 
       if (!visit_table.get(w)) {
         q.push(w);
-        m_backtrack[w] = *it;
+        m_backtrack[w] = g.getLink(csr.edge_ids[i]);
       }
     }
   }
-  trace = print();
+  if (!found) {
+    return;
+  }
+
+  // backwards from m_end
+  m_links.clear();
+  Link *link = m_backtrack[m_end];
+  while (!link->circle() && link->source.id != m_start) {
+    m_links.push_back(link->edge.id);
+    link = m_backtrack[link->source.id];
+  }
+  m_links.push_back(link->edge.id);
+  reverse(m_links.begin(), m_links.end());
+  sink.emit(g, link->source.id, m_links.data(), m_links.size());
 }
 
 void GraphTravellerBfsOne::configure(const Properties &config) {
@@ -563,184 +878,337 @@ void GraphTravellerBfsOne::startOver(const Graph &g) {
   m_backtrack.resize(g.size(), nullptr);
 }
 
-string GraphTravellerBfsOne::print() const {
-  Link *link = m_backtrack[m_end];
-  string path;
-
-  while (!link->circle() && link->source->id != m_start) {
-    path = "--" + link->edge->name() + "-->" + link->target->name() + path;
-    link = m_backtrack[link->source->id];
+void GraphTravellerEuler::travel(const Graph &g, CaseSink &sink) {
+  if (g.size() == 0) {
+    return;
   }
-
-  path = link->source->name() + "--" + link->edge->name() + "-->" +
-         link->target->name() + path;
-  return path;
-}
-
-void GraphTravellerEuler::travel(const Graph &g, string &trace) {
   if (!g.eulerian()) {
     cout << "the graph is not Eulerian graph" << '\n';
     return;
   }
 
-  startOver(g);
-
-  LinkList const adj = g.getAdjacencies(m_start);
-  if (adj.empty()) {
+  const CsrGraph &csr = g.csr();
+  if (csr.degree(m_start) == 0) {
     return;
   }
-
-  while (!m_visit_table->all1()) {
-    walk(g);
-    freeVertex();
+  if (m_split > 1) {
+    split(g, sink);
+    return;
   }
 
-  trace = print();
+  sink.beginCase(g, m_start);
+  tour(g, [&csr, &sink](const uint32_t i) { sink.append(csr.edge_ids[i]); });
+  sink.endCase();
 }
 
-void GraphTravellerEuler::configure(const Properties &config) {
-  Properties::const_iterator const it = config.find("START");
-  if (it != config.end()) {
-    m_start = it->second;
-  } else {
-    m_start = 0;
+void GraphTravellerEuler::tour(const Graph &g,
+                               const function<void(uint32_t)> &walk) {
+  size_t const walked =
+      (m_threads > 0) ? tourParallel(g, walk) : tourSequential(g, walk);
+
+  // balanced but not connected, some links are out of reach of the start
+  size_t walks = 0;
+  for (uint32_t const m : g.multiplicities()) {
+    walks += m;
+  }
+  if (walked != walks) {
+    throw std::logic_error("the graph is not eulerian graph");
   }
 }
 
-string GraphTravellerEuler::print() {
-  if (m_euler_cycle.empty()) {
-    return "";
-  }
+size_t GraphTravellerEuler::tourSequential(
+    const Graph &g, const function<void(uint32_t)> &walk) {
+  const CsrGraph &csr = g.csr();
+  startOver(g);
 
-  // shift start point on top
-  while (m_start != m_euler_cycle.front()->from->id) {
-    Link *link = m_euler_cycle.front();
-    m_euler_cycle.erase(m_euler_cycle.begin());
-    m_euler_cycle.push_back(link);
-  }
+  // the trail walked backwards, a vertex and the position of the link which
+  // leaves it towards the previous vertex of the trail
+  // a popped vertex is the next vertex of the tour, so the tour is written
+  // from m_start forwards
+  uint32_t const none = static_cast<uint32_t>(-1);
+  vector<pair<VERTEX_ID, uint32_t>> trail;
+  trail.emplace_back(m_start, none);
+  size_t walked = 0;
+  while (!trail.empty()) {
+    VERTEX_ID const v = trail.back().first;
+    uint32_t &k = m_cursor[v];
+    while (k < csr.rend(v) &&
+           m_remaining[csr.edge_ids[csr.rev_links[k]]] == 0) {
+      ++k;
+    }
+
+    if (k < csr.rend(v)) {
+      // an unused link, the cursor stays until all its walks are used
+      uint32_t const i = csr.rev_links[k];
+      m_remaining[csr.edge_ids[i]]--;
+      trail.emplace_back(csr.rev_sources[k], i);
+      continue;
+    }
 
-  LinkList::const_iterator it = m_euler_cycle.begin();
-  string path = (*it)->from->name();
-  while (it != m_euler_cycle.end()) {
-    path += "--" + (*it)->edge->name() + "-->" + (*it)->to->name();
-    ++it;
+    uint32_t const i = trail.back().second;
+    if (i != none) {
+      walk(i);
+      ++walked;
+    }
+    trail.pop_back();
   }
-  return path;
+  return walked;
 }
 
-void GraphTravellerEuler::startOver(const Graph &g) {
-  m_euler_cycle.clear();
-  /*
-  while (!m_euler_cycle.empty()) {
-    m_euler_cycle.pop();  // clean up the tour
+size_t GraphTravellerEuler::tourParallel(const Graph &g,
+                                         const function<void(uint32_t)> &walk) {
+  const CsrGraph &csr = g.csr();
+  const vector<uint32_t> &multiplicity = g.multiplicities();
+  m_first_walk.assign(csr.links() + 1, 0);
+  for (size_t i = 0; i < csr.links(); ++i) {
+    m_first_walk[i + 1] = m_first_walk[i] + multiplicity[csr.edge_ids[i]];
+  }
+  size_t const vertices = csr.vertices();
+  size_t const walks = m_first_walk.back();
+  m_walk_link.resize(walks);
+  m_next_walk.resize(walks);
+  m_trail.resize(walks);
+
+  // the k-th walk entering a vertex goes on with the k-th walk leaving it,
+  // every walk has one walk after it and one before it, so they part into
+  // closed trails
+  atomic<size_t> next(0);
+  runWorkers(workers(vertices), [this, &csr, &next, vertices]() {
+    for (size_t first = next.fetch_add(EULER_CHUNK); first < vertices;
+         first = next.fetch_add(EULER_CHUNK)) {
+      for (size_t v = first; v < min(vertices, first + EULER_CHUNK); ++v) {
+        for (uint32_t i = csr.begin(v); i < csr.end(v); ++i) {
+          for (uint32_t w = m_first_walk[i]; w < m_first_walk[i + 1]; ++w) {
+            m_walk_link[w] = i;
+          }
+        }
+        uint32_t leaving = m_first_walk[csr.begin(v)];
+        for (uint32_t k = csr.rbegin(v); k < csr.rend(v); ++k) {
+          uint32_t const i = csr.rev_links[k];
+          for (uint32_t w = m_first_walk[i]; w < m_first_walk[i + 1]; ++w) {
+            m_next_walk[w] = leaving++;
+          }
+        }
+      }
+    }
+  });
+
+  // a worker follows the trail of every walk not claimed yet, the walks it
+  // claims are labelled with the walk it started from, it stops on a claimed
+  // walk: the start when the trail is closed, or a walk another worker
+  // claimed on the same trail, the two parts are joined afterwards
+  AtomicBitMap claimed(walks);
+  vector<pair<uint32_t, uint32_t>> stops;
+  mutex lock;
+  next = 0;
+  runWorkers(workers(walks), [this, &claimed, &stops, &lock, &next, walks]() {
+    vector<pair<uint32_t, uint32_t>> mine;
+    for (size_t first = next.fetch_add(EULER_CHUNK); first < walks;
+         first = next.fetch_add(EULER_CHUNK)) {
+      for (size_t w = first; w < min(walks, first + EULER_CHUNK); ++w) {
+        if (claimed.get(w, memory_order_relaxed) || claimed.test_and_set(w)) {
+          continue;
+        }
+        m_trail[w] = w;
+        uint32_t x = m_next_walk[w];
+        for (; !claimed.test_and_set(x); x = m_next_walk[x]) {
+          m_trail[x] = w;
+        }
+        if (x != w) {
+          mine.emplace_back(w, x);
+        }
+      }
+    }
+    lock_guard<mutex> guard(lock);
+    stops.insert(stops.end(), mine.begin(), mine.end());
+  });
+  for (const pair<uint32_t, uint32_t> &stop : stops) {
+    uint32_t const a = trail(stop.first);
+    uint32_t const b = trail(m_trail[stop.second]);
+    if (a != b) {
+      m_trail[a] = b;
+    }
   }
-  */
 
-  if (m_visit_table) {
-    delete m_visit_table;
+  // splice the trails at the vertices they share, swapping the walks after
+  // two entering walks of different trails makes one trail of them
+  uint32_t const none = static_cast<uint32_t>(-1);
+  for (size_t v = 0; v < vertices; ++v) {
+    uint32_t entering = none;
+    for (uint32_t k = csr.rbegin(v); k < csr.rend(v); ++k) {
+      uint32_t const i = csr.rev_links[k];
+      for (uint32_t w = m_first_walk[i]; w < m_first_walk[i + 1]; ++w) {
+        if (entering == none) {
+          entering = w;
+          continue;
+        }
+        uint32_t const a = trail(entering);
+        uint32_t const b = trail(w);
+        if (a != b) {
+          swap(m_next_walk[entering], m_next_walk[w]);
+          m_trail[a] = b;
+        }
+      }
+    }
   }
-  m_visit_table = new BitMap(g.getLinks().size()); // reset the visit trace
 
-  m_vertices.clear(); // reset the vertices set
-  for (size_t i = 0; i < g.size(); ++i) {
-    m_vertices.push_back(*g.getVertex(i));
-  }
+  // some trails may share no vertex with the tour
+  uint32_t const start = m_first_walk[csr.begin(m_start)];
+  size_t walked = 0;
+  uint32_t w = start;
+  do {
+    walk(m_walk_link[w]);
+    ++walked;
+    w = m_next_walk[w];
+  } while (w != start && walked < walks);
+  return walked;
 }
 
-// find a Euler cycle in graph
-void GraphTravellerEuler::walk(const Graph &g) {
-  // this finction is to find a circuit in directed Eulerian graph
-  // based on Hierholzer's algorithm
-  // each walk will start from an available vertex,
-  // available vertex means the vertex has at least one incoming edge and
-  // one outgoing edge, since it is directed Eulerian graph, the in degree
-  // and out degree of any vertex are always same, so following randomly
-  // selected unvisited edge will always lead the walking arriving the
-  // origination (destination) vertex.
-  //
-  // assuming the previous trail already has a circle in m_euler_cycle, and
-  // the last vertex in the trail is available vertex, the function will find
-  // a circuit with exploring unvisited edges and back to the originate vertex
-  //
-
-  if (!g.eulerian()) {
-    throw std::logic_error("graph is not Eulerian");
+void GraphTravellerEuler::split(const Graph &g, CaseSink &sink) {
+  const CsrGraph &csr = g.csr();
+  vector<uint32_t> walks;
+  tour(g, [&walks](const uint32_t i) { walks.push_back(i); });
+
+  // BFS from the start, the link to every vertex on a shortest path and the
+  // vertex it leaves
+  uint32_t const none = static_cast<uint32_t>(-1);
+  vector<uint32_t> distance(csr.vertices(), none);
+  vector<uint32_t> parent(csr.vertices(), none);
+  vector<VERTEX_ID> previous(csr.vertices(), m_start);
+  vector<VERTEX_ID> queue(1, m_start);
+  distance[m_start] = 0;
+  for (size_t head = 0; head < queue.size(); ++head) {
+    VERTEX_ID const v = queue[head];
+    for (uint32_t i = csr.begin(v); i < csr.end(v); ++i) {
+      VERTEX_ID const w = csr.targets[i];
+      if (distance[w] == none) {
+        distance[w] = distance[v] + 1;
+        parent[w] = i;
+        previous[w] = v;
+        queue.push_back(w);
+      }
+    }
   }
 
-  VERTEX_ID v = m_start;
-  if (!m_euler_cycle.empty()) { // if there is previous cycle, use the last
-                                // vertex as the new start point
-    v = m_euler_cycle.back()->to->id;
+  // a piece starting at the a-th walk resets to its source first
+  vector<uint32_t> reset(walks.size());
+  for (size_t a = 0; a < walks.size(); ++a) {
+    reset[a] = (a == 0) ? 0 : distance[csr.targets[walks[a - 1]]];
   }
 
-  VERTEX_ID const dest = v;
-
-  bool found = false;
-  while (m_vertices[v].out_degree > 0 && !found) {
-    if (m_vertices[v].out_degree == 0) {
-      cout << "can't go further from " << v << '\n';
-      throw std::logic_error("Euler walk terminated at " +
-                             m_vertices[v].name());
+  // the shortest longest piece, the pieces get fewer as they may be longer
+  vector<size_t> cuts;
+  size_t low = max<size_t>(1, (walks.size() + m_split - 1) / m_split);
+  size_t high = walks.size();
+  while (low < high) {
+    size_t const length = low + (high - low) / 2;
+    if (cut(reset, length, cuts) <= m_split) {
+      high = length;
+    } else {
+      low = length + 1;
     }
+  }
+  cut(reset, low, cuts);
 
-    LinkList adj = g.getAdjacencies(v);
-    for (LinkList::iterator it = adj.begin(); it != adj.end(); ++it) {
-      if (m_visit_table->get((*it)->edge->id)) {
-        continue; // if the edge was visited, skip
-      }
+  vector<uint32_t> prefix;
+  for (size_t p = 0; p < cuts.size(); ++p) {
+    size_t const first = cuts[p];
+    size_t const last = (p + 1 < cuts.size()) ? cuts[p + 1] : walks.size();
+    sink.beginCase(g, m_start);
 
-      // found an available out edge
-      m_euler_cycle.push_back(*it);        // added in the trail
-      m_visit_table->set((*it)->edge->id); // mark the edge as visited
-      m_vertices[v].out_degree--;          // reduce the out degree of v
-      v = (*it)->to->id;
-      m_vertices[v].in_degree--; // and the in degree of next vertex
+    prefix.clear();
+    VERTEX_ID v = (first == 0) ? m_start : csr.targets[walks[first - 1]];
+    for (; v != m_start; v = previous[v]) {
+      prefix.push_back(parent[v]);
+    }
+    for (auto it = prefix.rbegin(); it != prefix.rend(); ++it) {
+      sink.append(csr.edge_ids[*it]);
+    }
+    for (size_t a = first; a < last; ++a) {
+      sink.append(csr.edge_ids[walks[a]]);
+    }
+    sink.endCase();
+  }
+}
 
-      if (v == dest) { // found, stop searching
-        found = true;
+size_t GraphTravellerEuler::cut(const vector<uint32_t> &reset,
+                                const size_t length,
+                                vector<size_t> &cuts) const {
+  // as a jump game: a piece starting at walk a may end anywhere up to
+  // a + length - reset[a], the starts reached with l pieces before them
+  // are the l-th range, the fewest pieces are found range by range
+  size_t const walks = reset.size();
+  size_t const none = static_cast<size_t>(-1);
+  auto reach = [&reset, length, none](const size_t a) {
+    return (reset[a] < length) ? a + length - reset[a] : none;
+  };
+  vector<pair<size_t, size_t>> ranges(1, make_pair(0, 0));
+  for (;;) {
+    size_t farthest = 0;
+    for (size_t a = ranges.back().first; a <= ranges.back().second; ++a) {
+      if (reach(a) != none) {
+        farthest = max(farthest, reach(a));
       }
+    }
+    if (farthest >= walks) {
       break;
     }
+    if (farthest <= ranges.back().second) {
+      return none; // too short for a reset
+    }
+    ranges.emplace_back(ranges.back().second + 1, farthest);
   }
-}
 
-// get the vertex in the path which has out going link
-// this function also shifts the cycle to keep the available vertex at the rear
-// of the path in order to start a new circle
-VERTEX_ID GraphTravellerEuler::freeVertex() {
-  if (m_euler_cycle.empty()) {
-    throw std::logic_error("euler cycle is empty");
+  // back from the end, a start of every range which reaches the next cut
+  cuts.assign(ranges.size(), 0);
+  size_t next = walks;
+  for (size_t l = ranges.size(); l-- > 0;) {
+    size_t a = ranges[l].first;
+    while (reach(a) == none || reach(a) < next) {
+      ++a;
+    }
+    cuts[l] = next = a;
   }
+  return cuts.size();
+}
 
-  // make sure the trail is a circuit
-  if (m_euler_cycle.front()->from->id != m_euler_cycle.back()->to->id) {
-    throw std::logic_error("euler cycle is not a circuit");
+uint32_t GraphTravellerEuler::trail(uint32_t walk) {
+  // path halving
+  while (m_trail[walk] != walk) {
+    m_trail[walk] = m_trail[m_trail[walk]];
+    walk = m_trail[walk];
   }
+  return walk;
+}
 
-  // turn the circle around until the rear vertex has uncovered edge
-  // i.e. the last link->to->out_degree > 0
-  // while went through all the vertices in the path but didn't found any
-  // uncovered edge i.e. all vertex->out_degree == 0 stop the loop use a counter
-  // to record how many steps has been taken
-  size_t steps = 0;
-  Link *link = m_euler_cycle.back();
-  while ((m_vertices[link->target->id].out_degree == 0) &&
-         (steps < m_euler_cycle.size())) {
-    link = m_euler_cycle.front();
-    // each vertex in the cycle should have equal in and out degree
-    if (m_vertices[link->source->id].balance() != 0) {
-      throw std::logic_error("vertex in the euler cycle is not balanced");
-    }
-    m_euler_cycle.erase(m_euler_cycle.begin());
-    m_euler_cycle.push_back(link);
-    ++steps;
-  }
+size_t GraphTravellerEuler::workers(const size_t tasks) const {
+  return max<size_t>(1, min(m_threads, tasks / EULER_CHUNK));
+}
 
-  // if all the vertices explored, the graph should be fully covered
-  if (steps == m_euler_cycle.size()) {
-    if (!m_visit_table->all1()) {
-      throw std::logic_error("the graph is not eulerian graph");
-    }
+void GraphTravellerEuler::configure(const Properties &config) {
+  Properties::const_iterator it = config.find("START");
+  if (it != config.end()) {
+    m_start = it->second;
+  } else {
+    m_start = 0;
   }
-  return link->target->id;
+  it = config.find("PARALLEL");
+  if (it != config.end() && it->second > 0) {
+    m_threads = it->second;
+  } else {
+    m_threads = 0;
+  }
+  it = config.find("SPLIT");
+  if (it != config.end() && it->second > 1) {
+    m_split = it->second;
+  } else {
+    m_split = 1;
+  }
+}
+
+void GraphTravellerEuler::startOver(const Graph &g) {
+  // an edge is walked as many times as its multiplicity
+  m_remaining = g.multiplicities();
+  const CsrGraph &csr = g.csr();
+  m_cursor.assign(csr.rev_offsets.begin(), csr.rev_offsets.end() - 1);
 }
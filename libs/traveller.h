@@ -1,12 +1,19 @@
 #ifndef CASEGEN_TRAVELLER_H_
 #define CASEGEN_TRAVELLER_H_
 
+#include "case_sink.h"
 #include "graph.h"
 
+#include <atomic>
 #include <climits>
+#include <deque>
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <ostream>
 #include <queue>
 #include <string>
+#include <vector>
 
 typedef std::map<std::string, int> Properties;
 
@@ -32,7 +39,11 @@ public:
   IGraphTraveller &operator=(IGraphTraveller &&rhs) = delete;
 
   // interfaces
-  virtual void travel(const Graph &g, string &trace) = 0;
+  // hand every case over to the sink as soon as it is found
+  virtual void travel(const Graph &g, CaseSink &sink) = 0;
+  // the cases as text, one case per line
+  void travel(const Graph &g, std::string &trace);
+  void stream(const Graph &g, std::ostream &out);
   virtual void configure(const Properties &config) = 0;
   virtual GT_ALGORITHM algorithm() = 0;
 
@@ -48,14 +59,12 @@ class GraphTravellerBfs : public IGraphTraveller {
 public:
   GraphTravellerBfs() : m_nodes(0), m_random(false){};
 
-  void travel(const Graph &g, string &trace) override;
+  using IGraphTraveller::travel;
+  void travel(const Graph &g, CaseSink &sink) override;
   void configure(const Properties &config) override{};
 
   GT_ALGORITHM algorithm() override { return GT_BFS; };
 
-  static LinkList shortestPath(const Graph &graph, const Vertex &from,
-                               const Vertex &to);
-
 protected:
   virtual void resetVisitBits();
   virtual void startOver(const Graph &g);
@@ -64,13 +73,14 @@ protected:
 
   size_t m_nodes;
   bool m_random;
-  vector<char> m_bits;
+  std::vector<char> m_bits;
 };
 
 // depth first search
 class GraphTravellerDfs : public IGraphTraveller {
 public:
-  virtual void travel(const Graph &g, string &trace);
+  using IGraphTraveller::travel;
+  virtual void travel(const Graph &g, CaseSink &sink);
   virtual void configure(const Properties &config){};
 
   inline virtual GT_ALGORITHM algorithm() { return GT_DFS; };
@@ -79,10 +89,12 @@ protected:
   virtual void startOver(const Graph &g);
   virtual void visit(const VERTEX_ID v_id, const bool mark = true);
   virtual bool isVisited(const VERTEX_ID v_id) const;
-  virtual string print(const VERTEX_ID start, const VERTEX_ID end,
-                       const LinkList &backtrack) const;
+  // the links from start to end on the backtrack, the start of the case
+  virtual VERTEX_ID path(const VERTEX_ID start, const VERTEX_ID end,
+                         const LinkList &backtrack,
+                         std::vector<LINK_ID> &links) const;
 
-  BitMap *m_visit_table = nullptr;
+  BitMap m_visit_table{0};
 
   friend class IGraphTraveller;
 };
@@ -90,18 +102,17 @@ protected:
 // depth first search on path
 class GraphTravellerDfsPath : public GraphTravellerDfs {
 public:
-  virtual void travel(const Graph &g, string &trace);
+  using IGraphTraveller::travel;
+  virtual void travel(const Graph &g, CaseSink &sink);
   virtual void configure(const Properties &config){};
 
   inline virtual GT_ALGORITHM algorithm() { return GT_DFS_PATH; };
 
 protected:
   virtual void startOver(const Graph &g);
-  virtual string print(const VERTEX_ID start, const VERTEX_ID end,
-                       const LinkList &backtrack) const;
 
 private:
-  void travel(const Graph &g, const LINK_ID v, string &trace);
+  void travel(const Graph &g, const LINK_ID v, CaseSink &sink);
   // calculate the uncovered out path of a vertex
   size_t uncoveredBranches(const Graph &g, const VERTEX_ID v,
                            const size_t steps) const;
@@ -113,52 +124,161 @@ private:
 };
 
 // search all possible paths from A to B with restriction
+// the depth is limited once a path is found, the first path may be longer
+// the branches which can not reach B within the depth are not entered, on a
+// RANDOM_WALK their links are not shuffled either, so a seeded walk does not
+// find its paths in the order of an unpruned search, it finds the same ones
+// when neither MAX_DEPTH nor MAX_CASES cuts the search
+//
+// with PARALLEL threads the search tree is cut at a shallow depth into tasks,
+// dealt to the workers, a worker takes the tasks from the back of its own
+// deque and steals from the front of the others once it is empty, every
+// worker has its own path stack and visit table, the cases are counted on a
+// shared atomic counter so the search stops at MAX_CASES, and handed over to
+// the sink under a lock by batches
+// the parallel depth limit is strict, no path longer than MAX_DEPTH, since
+// the first path found is not the same one on every run
+// with CANONICAL 1 the output is the same for any number of threads: the
+// tasks are taken in order, every task counts its own paths up to MAX_CASES
+// and a task holding a full batch waits until all the tasks before it are
+// handed over
+// RANDOM_WALK is ignored with PARALLEL threads, canonical or not, the links
+// are followed in the order of the frozen graph
 class GraphTravellerBfsAll : public GraphTravellerBfs {
   friend class IGraphTraveller;
 
 public:
   GraphTravellerBfsAll()
       : m_start(0), m_end(0), m_found(0), m_max_cases(UINT_MAX),
-        m_max_depth(UINT_MAX){};
+        m_max_depth(UINT_MAX), m_threads(0), m_canonical(false){};
 
-  void travel(const Graph &g, string &trace) final;
+  using IGraphTraveller::travel;
+  void travel(const Graph &g, CaseSink &sink) final;
 
   void configure(const Properties &config) final;
   GT_ALGORITHM algorithm() final { return GT_BFS_ALL; };
 
+  // paths found by the last travel
+  size_t found() const { return m_found; };
+
 protected:
   void startOver(const Graph &g) override;
-  virtual string print() const;
 
   virtual bool searchFurther() const;
 
-  vector<ELEMENT_ID> m_path;
+  std::vector<ELEMENT_ID> m_path;
+  // vertex -> hops to m_end, a branch is not explored if it can not reach
+  // m_end, or only by a path longer than m_max_depth
+  std::vector<uint32_t> m_distance;
 
   VERTEX_ID m_start, m_end;
 
   size_t m_found;
   size_t m_max_depth;
   size_t m_max_cases;
+  size_t m_threads; // 0 for the single threaded search
+  bool m_canonical;
 
 private:
+  // the adjacent nodes of a vertex of m_path still to visit, positions in
+  // the CSR arrays or, on a random walk, in m_adj
+  struct Frame {
+    uint32_t first;
+    uint32_t last;
+    uint32_t next;
+  };
+
+  // a subtree of the search, or only the paths ending one link after path
+  struct Task {
+    std::vector<ELEMENT_ID> path; // from m_start, as m_path
+    bool subtree;
+    size_t found;
+    // the links of the paths found and not handed over yet, ends[i] is the
+    // end of the i-th path
+    std::vector<LINK_ID> cases{};
+    std::vector<size_t> ends{};
+    bool done{false};
+  };
+
+  // a worker of the parallel search
+  struct Worker {
+    explicit Worker(size_t vertices) : visited(vertices, 0){};
+
+    std::vector<char> visited;
+    std::vector<Frame> frames;
+    std::vector<VERTEX_ID> vertices; // the vertices of the frames
+    std::vector<LINK_ID> links;      // the links down to the vertex entered
+    std::mutex lock;                 // guards tasks
+    std::deque<size_t> tasks;
+  };
+
+  // a parallel search
+  struct Run {
+    Run(const Graph &graph, CaseSink &case_sink, std::vector<Task> &all)
+        : g(graph), sink(case_sink), tasks(all){};
+
+    const Graph &g;
+    CaseSink &sink;
+    std::vector<Task> &tasks;
+    std::atomic<size_t> found{0};   // paths counted by the workers
+    std::mutex lock;                // guards sink and flushed
+    std::atomic<size_t> emitted{0}; // paths handed over to the sink
+    size_t flushed{0};              // canonical: the tasks handed over
+    std::atomic<size_t> next{0};    // canonical: the next task to take
+  };
+
   void explore(const Graph &graph, VERTEX_ID current_node_id);
+  // count the paths to m_end by one more link and push the frame of v,
+  // false if the search stops at v
+  bool enter(const CsrGraph &csr, const VERTEX_ID v);
+
+  void travelParallel(const Graph &g, CaseSink &sink);
+  // the tasks of the search tree down to depth, in the order of a single
+  // threaded search, visited holds the vertices of path
+  void split(const CsrGraph &csr, const size_t depth,
+             std::vector<char> &visited, std::vector<ELEMENT_ID> &path,
+             std::vector<Task> &tasks) const;
+  // whether the parallel search goes on to the neighbor, at depth
+  bool descend(const VERTEX_ID neighbor, const size_t depth,
+               const std::vector<char> &visited) const;
+  // whether the neighbor ends a path
+  bool arrive(const VERTEX_ID neighbor,
+              const std::vector<char> &visited) const {
+    return neighbor == m_end && (neighbor == m_start || !visited[neighbor]);
+  };
+  // the subtree of the task
+  void search(const CsrGraph &csr, Task &task, Worker &worker, Run &run) const;
+  // a path of the task, false once the search stops
+  bool accept(Run &run, Task &task, const std::vector<LINK_ID> &links) const;
+  // the paths held by the task to the sink, up to MAX_CASES
+  void handOver(Run &run, Task &task) const;
+  // canonical: hand over the paths of the tasks done, in order
+  void flush(Run &run) const;
+
+  std::vector<Frame> m_frames;
+  std::vector<uint32_t> m_adj;
+  // the sink of travel, the links of m_path
+  CaseSink *m_sink{nullptr};
+  const Graph *m_graph{nullptr};
+  std::vector<LINK_ID> m_case;
 };
 
 class GraphTravellerBfsOne : public GraphTravellerBfs {
   friend class IGraphTraveller;
 
 public:
-  void travel(const Graph &g, string &trace) override;
+  using IGraphTraveller::travel;
+  void travel(const Graph &g, CaseSink &sink) override;
   void configure(const Properties &config) override;
 
   inline virtual GT_ALGORITHM algorithm() { return GT_BFS_ONE; };
 
 protected:
   virtual void startOver(const Graph &g);
-  virtual string print() const;
 
   VERTEX_ID m_start, m_end;
   LinkList m_backtrack;
+  std::vector<LINK_ID> m_links; // the links of the path, reused
 };
 
 class GraphTravellerEuler : public IGraphTraveller {
@@ -178,37 +298,76 @@ class GraphTravellerEuler : public IGraphTraveller {
    * that has adjacent edges not part of the tour, start another trail from u,
    * following unused edges until returning to u, and join the tour formed in
    * this way to the previous tour.
+   *
+   * Done in O(V + E) with an explicit stack of the current trail: every
+   * vertex has a cursor on its next unused link, a vertex with no link left
+   * is popped and its link goes to the tour, so the sub-tours are spliced
+   * where they start without moving the tour.
+   *
+   * The trail follows the links backwards, on the reverse index of the
+   * frozen graph, so the links are popped in the order of the tour and
+   * written out at once, only the trail is held in memory.
+   *
+   * With PARALLEL threads the closed trails are found at once instead: at
+   * every vertex the k-th walk entering it is followed by the k-th walk
+   * leaving it, which parts the walks into closed trails. The workers follow
+   * them from every walk, claiming the walks on an atomic bit map, and two
+   * trails through the same vertex are spliced by swapping the walks which
+   * follow their entering walks there, until one circuit is left. The trails
+   * are kept in a union-find, so the tour does not depend on the threads.
+   *
+   * With SPLIT n the tour is cut into at most n cases, each one starts from
+   * START with a shortest path to the first vertex of its part of the tour.
+   * The cuts make the longest case as short as possible.
    */
 public:
-  GraphTravellerEuler() : m_start(0), m_random(true), m_visit_table(nullptr){};
-  virtual ~GraphTravellerEuler() {
-    if (m_visit_table) {
-      delete m_visit_table;
-    }
-    m_visit_table = nullptr;
-    m_euler_cycle.clear();
-    // while (!m_euler_cycle.empty()) m_euler_cycle.pop();
-    m_vertices.clear();
-  };
+  GraphTravellerEuler()
+      : m_random(true), m_start(0), m_threads(0), m_split(1){};
 
-  virtual void travel(const Graph &g, string &trace);
+  using IGraphTraveller::travel;
+  void travel(const Graph &g, CaseSink &sink) override;
   virtual void configure(const Properties &config);
 
   inline virtual GT_ALGORITHM algorithm() { return GT_EULER; };
 
-protected:
-  virtual string print();
-
 private:
   void startOver(const Graph &g);
-  void walk(const Graph &g);
-  VERTEX_ID freeVertex();
-
-  BitMap *m_visit_table;
+  // walk every link of the tour from m_start in order, by its position in
+  // the CSR arrays
+  void tour(const Graph &g, const std::function<void(uint32_t)> &walk);
+  // Hierholzer, the links walked
+  size_t tourSequential(const Graph &g,
+                        const std::function<void(uint32_t)> &walk);
+  // the closed trails found by m_threads workers, the links walked
+  size_t tourParallel(const Graph &g,
+                      const std::function<void(uint32_t)> &walk);
+  // the tour in m_split cases
+  void split(const Graph &g, CaseSink &sink);
+  // the first walks of the fewest pieces of the tour no longer than length
+  // with their resets, reset[a] is the reset of a piece starting at walk a
+  // -1 if a reset is not shorter than length
+  size_t cut(const std::vector<uint32_t> &reset, const size_t length,
+             std::vector<size_t> &cuts) const;
+  // the trail holding the walk, its root in m_trail
+  uint32_t trail(uint32_t walk);
+  // the workers for the tasks, no more than a worker per chunk of tasks
+  size_t workers(const size_t tasks) const;
+
+  // edge -> walks left
+  std::vector<uint32_t> m_remaining;
+  // vertex -> position of its next unused entering link in the reverse index
+  std::vector<uint32_t> m_cursor;
   bool m_random;
   VERTEX_ID m_start;
-  LinkList m_euler_cycle;
-  vector<Vertex> m_vertices;
+  size_t m_threads; // 0 for the sequential tour
+  size_t m_split;   // cases of the tour
+
+  // the walks of the link at position i are m_first_walk[i] up to
+  // m_first_walk[i + 1], so the walks leaving a vertex are in a row
+  std::vector<uint32_t> m_first_walk;
+  std::vector<uint32_t> m_walk_link;  // walk -> position of its link
+  std::vector<uint32_t> m_next_walk;  // walk -> walk after it in its trail
+  std::vector<uint32_t> m_trail;      // walk -> parent in the union-find
 
   friend class IGraphTraveller;
 };
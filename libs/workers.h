@@ -0,0 +1,20 @@
+#ifndef CASEGEN_WORKERS_H_
+#define CASEGEN_WORKERS_H_
+
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+// run work on threads workers, the calling thread is one of them
+template <typename WORK> void runWorkers(const size_t threads, WORK work) {
+  std::vector<std::thread> workers;
+  for (size_t t = 1; t < threads; ++t) {
+    workers.emplace_back(work);
+  }
+  work();
+  for (std::thread &w : workers) {
+    w.join();
+  }
+}
+
+#endif
@@ -1,3 +1,4 @@
+#include "case_sink.h"
 #include "graph.h"
 #include "state_machine.h"
 #include "traveller.h"
@@ -6,7 +7,10 @@
 #include <cstdlib>
 #include <ctime>
 #include <iostream>
+#include <memory>
+#include <stdexcept>
 #include <string>
+#include <thread>
 #include <vector>
 
 //#include "platform/CmConfigInitFile.h"
@@ -35,10 +39,26 @@ void printHelp() {
        << "The termination state the test case end with, default: 0\n";
   cout << "  -f file          "
        << "The input file of the state machine, default: m.txt\n";
+  cout << "  -w file          "
+       << "Write the cases to the file instead of the standard output\n";
   cout << "  --random         "
        << "Generating cases random-walking\n";
   cout << "  --dump           "
        << "Print out the graph\n";
+  cout << "  --sparse         "
+       << "Keep the reachable table compressed, for big sparse graphs\n";
+  cout << "  -j threads       "
+       << "The threads scanning the graph, default: all the cores\n";
+  cout << "  -k pieces        "
+       << "Split the Euler tour into pieces of about the same length\n";
+  cout << "  --parallel       "
+       << "Build the Euler tour or search all the paths on the threads of -j\n";
+  cout << "  --canonical      "
+       << "Find the same paths in the same order with --parallel on any\n";
+  cout << "                   "
+       << "number of threads of -j\n";
+  cout << "  --closure        "
+       << "Build the reachable table by bit matrix transitive closure\n";
   cout << "  --gensm          "
        << "Generating state machine from state list\n";
   cout << "  --sf file        "
@@ -48,6 +68,7 @@ void printHelp() {
 int main(int argc, char *argv[]) {
   string strConfigFileName = "m.txt";
   string strStateFileName  = "s.txt";
+  string strCaseFileName;
   bool   readFromStateFile = false;
   string strStrategy       = "node";
   string start             = "0";
@@ -55,7 +76,13 @@ int main(int argc, char *argv[]) {
   size_t max_depth         = UINT_MAX;
   size_t max_cases         = UINT_MAX;
   size_t random            = 0;
+  size_t pieces            = 1;
   bool   dump              = false;
+  bool   sparse            = false;
+  bool   closure           = false;
+  bool   parallel          = false;
+  bool   canonical         = false;
+  size_t threads           = 0;
 
   for (int i = 1; i < argc; ++i) {
     if (string("-s") == argv[i]) {
@@ -100,6 +127,13 @@ int main(int argc, char *argv[]) {
       continue;
     }
 
+    if (string("-w") == argv[i]) {
+      if (i < argc) {
+        strCaseFileName = string(argv[++i]);
+      }
+      continue;
+    }
+
     if (string("--random") == argv[i]) {
       random = 1;
       srand((unsigned int)time(nullptr));
@@ -111,6 +145,40 @@ int main(int argc, char *argv[]) {
       return 0;
     }
 
+    if (string("--sparse") == argv[i]) {
+      sparse = true;
+      continue;
+    }
+
+    if (string("-j") == argv[i]) {
+      if (i < argc) {
+        threads = atoi(argv[++i]);
+      }
+      continue;
+    }
+
+    if (string("-k") == argv[i]) {
+      if (i < argc) {
+        pieces = atoi(argv[++i]);
+      }
+      continue;
+    }
+
+    if (string("--parallel") == argv[i]) {
+      parallel = true;
+      continue;
+    }
+
+    if (string("--canonical") == argv[i]) {
+      canonical = true;
+      continue;
+    }
+
+    if (string("--closure") == argv[i]) {
+      closure = true;
+      continue;
+    }
+
     if (string("--dump") == argv[i]) {
       dump = true;
     }
@@ -169,8 +237,23 @@ return 0;
   config["MAX_DEPTH"]   = max_depth;
   config["MAX_CASES"]   = max_cases;
   config["RANDOM_WALK"] = random;
+  config["SPLIT"]       = pieces;
+  config["CANONICAL"]   = canonical;
+  if (parallel && random && strStrategy == "all") {
+    cerr << "--random is ignored searching all the paths with --parallel\n";
+  }
+  if (parallel) {
+    config["PARALLEL"] = threads > 0 ? threads : thread::hardware_concurrency();
+  }
 
   StateMachine stateMachine;
+  if (sparse) {
+    stateMachine.setReachPolicy(Graph::RP_SPARSE);
+  }
+  if (closure) {
+    stateMachine.setScanMethod(Graph::SCAN_CLOSURE);
+  }
+  stateMachine.setScanThreads(threads);
   if (readFromStateFile) {
     if (stateMachine.generate(strStateFileName) == nullptr) {
       return -1;
@@ -196,13 +279,32 @@ return 0;
     end_points.push_back(atoi(end.c_str()));
   }
 
+  // the cases of all the pairs go to one sink, written as they are found
+  unique_ptr<StreamSink> sink;
+  if (strCaseFileName.empty()) {
+    sink.reset(new StdoutSink());
+  } else {
+    try {
+      sink.reset(new FileSink(strCaseFileName));
+    } catch (const runtime_error &e) {
+      cerr << e.what() << "\n";
+      return -1;
+    }
+  }
+
   for (size_t i = 0; i < start_points.size(); ++i) {
     for (size_t j = 0; j < end_points.size(); ++j) {
       config["START"] = start_points[i];
       config["END"]   = end_points[j];
       stateMachine.configure(config);
-      cout << stateMachine.cases() << "\n";
+      stateMachine.cases(*sink);
     }
   }
+  try {
+    sink->finish();
+  } catch (const runtime_error &e) {
+    cerr << e.what() << "\n";
+    return -1;
+  }
   return 0;
 }